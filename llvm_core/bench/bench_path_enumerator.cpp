@@ -0,0 +1,281 @@
+// Compares the per-step cost of the PathStream DFS against the original
+// recursive findAllPaths (BasicBlock* frames, std::unordered_map visit counts)
+// on synthetic CFGs. Both engines only count paths, so the numbers measure
+// the traversal itself and not path copying.
+//
+// The workloads are a chain of 16 diamonds (65536 paths), a loop whose body
+// is a chain of 6 diamonds with at most 2 iterations (4161 paths) and a
+// straight line of 20000 blocks. On a 1-vCPU Intel Xeon VM (g++ 12.2,
+// LLVM 14.0.6, CMAKE_BUILD_TYPE=Release, three runs) the stream is
+// 5-6x, 4x and 10-14x faster per step. Without a build type the code is
+// unoptimized and the gap shrinks to about 3x, 1.7x and 3x.
+//
+// A second table compares the memory needed to keep an enumeration as
+// std::vector<Path>, as a flat PathStore and as a PathTrie, and a third one
+// the scaling of ParallelPathEnumerator with the number of threads. The
+// latter has only been run on the single-core VM above, which shows the
+// overhead of the pool (2 threads at parity) but not the multi-core speedup.
+#include "ParallelPathEnumerator.h"
+#include "PathEnumerator.h"
+#include "PathStore.h"
+#include "PathTrie.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+using namespace llvm;
+using namespace hepf;
+
+namespace {
+
+// -----------------------------------------------------------
+// Reference engine: the recursive enumerator this benchmark replaces
+// -----------------------------------------------------------
+struct RecursiveEnumerator {
+  size_t maxPaths;
+  size_t maxLoopIterations;
+  size_t pathCount = 0;
+  size_t steps = 0;
+  size_t checksum = 0;
+
+  void findAllPaths(BasicBlock *current, std::vector<BasicBlock *> &currentPath,
+                    std::unordered_map<BasicBlock *, size_t> &visitCount) {
+    if (pathCount >= maxPaths)
+      return;
+    if (visitCount[current] > maxLoopIterations)
+      return;
+
+    steps++;
+    currentPath.push_back(current);
+    visitCount[current]++;
+
+    if (succ_begin(current) == succ_end(current)) {
+      pathCount++;
+      checksum += currentPath.size();
+    } else {
+      for (BasicBlock *succ : successors(current)) {
+        if (pathCount >= maxPaths)
+          break;
+        findAllPaths(succ, currentPath, visitCount);
+      }
+    }
+
+    currentPath.pop_back();
+    if (--visitCount[current] == 0)
+      visitCount.erase(current);
+  }
+};
+
+// -----------------------------------------------------------
+// Synthetic workloads
+// -----------------------------------------------------------
+// Emit 'count' if/else diamonds starting at 'BB'; returns the join block
+BasicBlock *emitDiamonds(Function *F, BasicBlock *BB, Value *Cond,
+                         unsigned count, const std::string &prefix) {
+  LLVMContext &C = F->getContext();
+  for (unsigned i = 0; i < count; ++i) {
+    std::string id = prefix + std::to_string(i);
+    BasicBlock *Then = BasicBlock::Create(C, id + ".then", F);
+    BasicBlock *Else = BasicBlock::Create(C, id + ".else", F);
+    BasicBlock *Join = BasicBlock::Create(C, id + ".join", F);
+    IRBuilder<>(BB).CreateCondBr(Cond, Then, Else);
+    IRBuilder<>(Then).CreateBr(Join);
+    IRBuilder<>(Else).CreateBr(Join);
+    BB = Join;
+  }
+  return BB;
+}
+
+Function *createFunction(Module &M, const std::string &name) {
+  LLVMContext &C = M.getContext();
+  auto *FTy = FunctionType::get(Type::getVoidTy(C), {Type::getInt1Ty(C)},
+                                false);
+  return Function::Create(FTy, Function::ExternalLinkage, name, M);
+}
+
+// 2^count acyclic paths
+Function *buildDiamondChain(Module &M, unsigned count) {
+  Function *F = createFunction(M, "diamonds");
+  BasicBlock *Entry = BasicBlock::Create(M.getContext(), "entry", F);
+  BasicBlock *Exit = emitDiamonds(F, Entry, F->getArg(0), count, "d");
+  IRBuilder<>(Exit).CreateRetVoid();
+  return F;
+}
+
+// A loop whose body is a chain of diamonds, as left behind by unrolling
+Function *buildUnrolledLoop(Module &M, unsigned diamonds) {
+  LLVMContext &C = M.getContext();
+  Function *F = createFunction(M, "unrolled_loop");
+  Value *Cond = F->getArg(0);
+  BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+  BasicBlock *Header = BasicBlock::Create(C, "header", F);
+  BasicBlock *Body = BasicBlock::Create(C, "body", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+  IRBuilder<>(Entry).CreateBr(Header);
+  IRBuilder<>(Header).CreateCondBr(Cond, Body, Exit);
+  BasicBlock *Latch = emitDiamonds(F, Body, Cond, diamonds, "u");
+  IRBuilder<>(Latch).CreateBr(Header);
+  IRBuilder<>(Exit).CreateRetVoid();
+  return F;
+}
+
+// One very long straight-line path
+Function *buildStraightLine(Module &M, unsigned length) {
+  LLVMContext &C = M.getContext();
+  Function *F = createFunction(M, "straight_line");
+  BasicBlock *BB = BasicBlock::Create(C, "entry", F);
+  for (unsigned i = 0; i < length; ++i) {
+    BasicBlock *Next = BasicBlock::Create(C, "b" + std::to_string(i), F);
+    IRBuilder<>(BB).CreateBr(Next);
+    BB = Next;
+  }
+  IRBuilder<>(BB).CreateRetVoid();
+  return F;
+}
+
+double measureSeconds(const std::function<void()> &body, unsigned repeats) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < repeats; ++i)
+    body();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repeats;
+}
+
+void runWorkload(Function *F, size_t maxPaths, size_t maxLoopIterations,
+                 unsigned repeats) {
+  RecursiveEnumerator reference{maxPaths, maxLoopIterations};
+  double recursiveTime = measureSeconds(
+      [&] {
+        reference = RecursiveEnumerator{maxPaths, maxLoopIterations};
+        std::vector<BasicBlock *> currentPath;
+        std::unordered_map<BasicBlock *, size_t> visitCount;
+        reference.findAllPaths(&F->getEntryBlock(), currentPath, visitCount);
+      },
+      repeats);
+
+  auto CFG = std::make_shared<const CFGIndex>(*F);
+  size_t streamPaths = 0;
+  size_t streamChecksum = 0;
+  double streamTime = measureSeconds(
+      [&] {
+        PathStream S(CFG, maxPaths, maxLoopIterations);
+        streamPaths = 0;
+        streamChecksum = 0;
+        while (S.next()) {
+          streamPaths++;
+          streamChecksum += S.currentIndices().size();
+        }
+      },
+      repeats);
+
+  // Both engines perform the same block visits
+  double steps = static_cast<double>(reference.steps);
+  outs() << format("%-16s %10zu %12zu %12.2f %12.2f %8.2fx%s\n",
+                   F->getName().str().c_str(), reference.pathCount,
+                   reference.steps, recursiveTime * 1e9 / steps,
+                   streamTime * 1e9 / steps, recursiveTime / streamTime,
+                   (streamPaths == reference.pathCount &&
+                    streamChecksum == reference.checksum)
+                       ? ""
+                       : "  MISMATCH");
+}
+
+// Bytes held by a vector<Path> (ignoring allocator overhead per vector)
+size_t vectorStorageBytes(const std::vector<Path> &paths) {
+  size_t bytes = paths.capacity() * sizeof(Path);
+  for (const Path &path : paths)
+    bytes += path.capacity() * sizeof(BasicBlock *);
+  return bytes;
+}
+
+void reportStorage(Function *F, size_t maxPaths, size_t maxLoopIterations) {
+  auto CFG = std::make_shared<const CFGIndex>(*F);
+
+  std::vector<Path> paths;
+  PathStream S(CFG, maxPaths, maxLoopIterations);
+  while (S.next())
+    paths.push_back(S.current());
+
+  PathStream T(CFG, maxPaths, maxLoopIterations);
+  PathTrie Trie(T);
+
+  PathStore Store(CFG);
+  PathStream U(CFG, maxPaths, maxLoopIterations);
+  Store.append(U);
+  Store.shrinkToFit();
+
+  size_t vectorBytes = vectorStorageBytes(paths);
+  size_t storeBytes = Store.getMemoryUsage();
+  size_t trieBytes = Trie.getMemoryUsage();
+  outs() << format("%-16s %10zu %12zu %12zu %12zu %12zu\n",
+                   F->getName().str().c_str(), paths.size(), vectorBytes,
+                   storeBytes, Trie.getNumNodes(), trieBytes);
+}
+
+bool sameBlocks(const PathStore &A, const PathStore &B) {
+  if (A.size() != B.size())
+    return false;
+  for (size_t i = 0; i < A.size(); ++i) {
+    if (A[i].getBlockIndices() != B[i].getBlockIndices())
+      return false;
+  }
+  return true;
+}
+
+void reportScaling(Function *F, size_t maxPaths, size_t maxLoopIterations) {
+  auto CFG = std::make_shared<const CFGIndex>(*F);
+
+  PathStore expected(CFG);
+  PathStream S(CFG, maxPaths, maxLoopIterations);
+  expected.append(S);
+
+  unsigned hardwareThreads = hardware_concurrency().compute_thread_count();
+  double baseline = 0.0;
+  for (unsigned threads = 1; threads <= std::max(hardwareThreads, 32u);
+       threads *= 2) {
+    ParallelPathEnumerator PPE(CFG, maxPaths, maxLoopIterations, threads);
+    PathStore paths(CFG);
+    double time = measureSeconds([&] { paths = PPE.run(); }, 3);
+    if (threads == 1)
+      baseline = time;
+    outs() << format("%-16s %10u %10zu %12.2f %8.2fx%s%s\n",
+                     F->getName().str().c_str(), threads, PPE.getNumTasks(),
+                     time * 1e3, baseline / time,
+                     threads > hardwareThreads ? "  (oversubscribed)" : "",
+                     sameBlocks(paths, expected) ? "" : "  MISMATCH");
+  }
+}
+
+} // anonymous namespace
+
+int main() {
+  LLVMContext C;
+  Module M("bench_path_enumerator", C);
+
+  outs() << "workload              paths        steps    recursive       stream"
+            "   speedup\n"
+         << "                                           (ns/step)    (ns/step)\n";
+
+  runWorkload(buildDiamondChain(M, 16), 1 << 20, 2, 5);
+  runWorkload(buildUnrolledLoop(M, 6), 1 << 20, 2, 5);
+  runWorkload(buildStraightLine(M, 20000), 1, 100, 20);
+
+  outs() << "\nworkload              paths   vector (B)    store (B)   trie nodes"
+            "     trie (B)\n";
+  reportStorage(M.getFunction("diamonds"), 5000, 2);
+  reportStorage(M.getFunction("unrolled_loop"), 5000, 2);
+
+  outs() << "\nworkload            threads      tasks    time (ms)   speedup\n";
+  reportScaling(buildDiamondChain(M, 18), 1 << 20, 2);
+  return 0;
+}
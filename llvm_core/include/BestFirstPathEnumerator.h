@@ -0,0 +1,78 @@
+#ifndef BEST_FIRST_PATH_ENUMERATOR_H
+#define BEST_FIRST_PATH_ENUMERATOR_H
+
+#include "CFGIndex.h"
+#include "EnumerationBudget.h"
+#include "PathStore.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hepf {
+
+// Path enumeration in order of decreasing probability.
+//
+// Partial paths wait in a priority queue keyed by the product of their edge
+// probabilities. The most probable one is extended by all successors allowed
+// by the loop bound of PathStream, and a complete path is emitted when it
+// reaches the front of the queue. Extending a path never raises its
+// probability, so complete paths come out most probable first, and the hot
+// paths are kept when maxPaths cuts the enumeration short. The enumeration
+// also stops once the emitted paths cover budget.coverage of the probability
+// mass.
+//
+// Partial paths are nodes of a prefix tree (block, parent), so a queue entry
+// costs a few words regardless of its length. The tree and the queue grow
+// with the frontier rather than the depth, which is what the time and memory
+// budgets bound.
+class BestFirstPathEnumerator {
+public:
+  // edgeProbabilities holds the probability of every CFGIndex edge (see
+  // CFGIndex::getEdgeProbabilities); if empty, the successors of a block are
+  // taken with equal probability
+  BestFirstPathEnumerator(std::shared_ptr<const CFGIndex> CFG,
+                          const EnumerationBudget &budget,
+                          std::vector<double> edgeProbabilities);
+
+  PathStore run();
+
+  // Which limit, if any, cut the enumeration short
+  BudgetLimit getLimitHit() const { return limitHit; }
+  // Total probability of the emitted paths
+  double getCoveredProbability() const { return covered; }
+
+private:
+  static constexpr uint32_t NoParent = UINT32_MAX;
+  // Reading the clock on every step would dominate a step
+  static constexpr unsigned DeadlineCheckInterval = 1024;
+
+  struct Node {
+    uint32_t block;
+    uint32_t parent;
+  };
+  struct Entry {
+    double probability;
+    uint32_t node;
+    // Most probable first; ties in creation order, for determinism
+    bool operator<(const Entry &other) const {
+      if (probability != other.probability)
+        return probability < other.probability;
+      return node > other.node;
+    }
+  };
+
+  double getEdgeProbability(uint32_t block, unsigned edge) const;
+  // Number of times block occurs on the partial path ending in node
+  unsigned countVisits(uint32_t node, uint32_t block) const;
+
+  std::shared_ptr<const CFGIndex> CFG;
+  EnumerationBudget budget;
+  std::vector<double> edgeProbabilities;
+  std::vector<Node> nodes;
+  BudgetLimit limitHit;
+  double covered;
+};
+
+} // namespace hepf
+
+#endif // BEST_FIRST_PATH_ENUMERATOR_H
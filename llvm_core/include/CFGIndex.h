@@ -0,0 +1,146 @@
+#ifndef CFG_INDEX_H
+#define CFG_INDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+class BranchProbabilityInfo;
+} // namespace llvm
+
+namespace hepf {
+
+// Dense, function-local numbering of basic blocks with flattened (CSR)
+// successor lists.
+//
+// Blocks are numbered in function layout order, so the entry block is always
+// block 0. Every terminator successor slot becomes one edge, in successor
+// order, which keeps duplicate edges (e.g. switch cases sharing a target)
+// distinct exactly as successors() reports them. Path algorithms can then
+// keep per-block and per-edge state in plain arrays instead of hash maps.
+//
+// With uniqueSuccessors, duplicate edges are merged instead: every target
+// appears once per block, at the position of its first successor slot, and
+// the edge records how many slots it stands for. A dispatch switch with many
+// cases sharing a target then no longer multiplies the paths through it.
+//
+// With superblocks, maximal straight-line chains (a block with a single
+// successor whose only predecessor it is, and so on) are contracted into one
+// node. Every path visits a chain as a whole, so the paths over the nodes are
+// exactly the paths over the blocks, with fewer DFS steps and shorter stored
+// paths. Node numbers then differ from block numbers: getBlock() returns the
+// first block of a node and getChain() all of them.
+//
+// With pruneCold, edges into subtrees whose every path ends cold are dropped,
+// so no enumeration over the index walks them. A block is cold if it ends in
+// unreachable or calls a noreturn or cold function, and an edge is cold if
+// its !prof branch weight is below ColdEdgeThreshold of its terminator's
+// total (loop exits excepted: every path out of a loop takes one). A block
+// is pruned if it cannot reach an exit that is not cold over edges and
+// blocks that are not cold; that includes a loop whose every exit leads to
+// cold code, which no path leaves. If that includes the entry block, nothing
+// is dropped.
+class CFGIndex {
+public:
+  // Share of a terminator's branch weights below which an edge is cold;
+  // __builtin_expect weights an unlikely edge 1 in 2001
+  static constexpr double ColdEdgeThreshold = 0.001;
+
+  explicit CFGIndex(llvm::Function &F, bool uniqueSuccessors = false,
+                    bool superblocks = false, bool pruneCold = false);
+
+  // Number of nodes: blocks, or chains with superblocks
+  unsigned size() const { return blocks.size(); }
+  bool empty() const { return blocks.empty(); }
+  unsigned getNumEdges() const { return succs.size(); }
+  bool hasUniqueSuccessors() const { return uniqueSuccessors; }
+  bool hasSuperblocks() const { return !chainOffsets.empty(); }
+  // Edges dropped by pruneCold
+  unsigned getNumPrunedEdges() const { return numPrunedEdges; }
+
+  llvm::BasicBlock *getBlock(unsigned block) const { return blocks[block]; }
+  // Index of BB (of its node, with superblocks), which must belong to the
+  // indexed function
+  unsigned getIndex(const llvm::BasicBlock *BB) const {
+    return blockIndex.lookup(BB);
+  }
+
+  // Blocks of a node in execution order: the block itself without superblocks
+  llvm::ArrayRef<llvm::BasicBlock *> getChain(unsigned node) const {
+    if (chainOffsets.empty())
+      return blocks[node];
+    return llvm::ArrayRef<llvm::BasicBlock *>(chainBlocks)
+        .slice(chainOffsets[node], chainOffsets[node + 1] - chainOffsets[node]);
+  }
+  unsigned getChainLength(unsigned node) const {
+    return chainOffsets.empty() ? 1
+                                : chainOffsets[node + 1] - chainOffsets[node];
+  }
+
+  // Edges out of a block are [edgeBegin(block), edgeEnd(block))
+  unsigned edgeBegin(unsigned block) const { return succOffsets[block]; }
+  unsigned edgeEnd(unsigned block) const { return succOffsets[block + 1]; }
+  unsigned getEdgeTarget(unsigned edge) const { return succs[edge]; }
+  // Terminator successor slot of an edge out of block; without
+  // uniqueSuccessors, where every edge is one slot
+  unsigned getEdgeSlot(unsigned block, unsigned edge) const {
+    return edgeSlots.empty() ? edge - edgeBegin(block) : edgeSlots[edge];
+  }
+  // Number of terminator successor slots merged into the edge
+  unsigned getEdgeMultiplicity(unsigned edge) const {
+    return uniqueSuccessors ? edgeMultiplicity[edge] : 1;
+  }
+  // Number of paths with duplicate successors that a path of this index
+  // stands for: the product of its edge multiplicities, saturating at
+  // UINT64_MAX. Always 1 without uniqueSuccessors.
+  uint64_t getPathMultiplicity(llvm::ArrayRef<uint32_t> path) const;
+  // Probability of every edge according to BPI. A merged edge is taken with
+  // the total probability of its slots, and a superblock branches from its
+  // last block. Unknown probabilities are 0.
+  std::vector<double>
+  getEdgeProbabilities(const llvm::BranchProbabilityInfo &BPI) const;
+
+  llvm::ArrayRef<uint32_t> successors(unsigned block) const {
+    return llvm::ArrayRef<uint32_t>(succs).slice(
+        edgeBegin(block), edgeEnd(block) - edgeBegin(block));
+  }
+
+  // Exit blocks have no successors
+  bool isExit(unsigned block) const {
+    return edgeBegin(block) == edgeEnd(block);
+  }
+
+  // Blocks reachable from the entry in reverse post-order: a topological
+  // order of the CFG without its back edges when the CFG is reducible
+  std::vector<uint32_t> getReversePostOrder() const;
+
+private:
+  // Drop the edges into cold subtrees
+  void pruneColdEdges();
+  // Merge straight-line chains into superblock nodes
+  void contractChains();
+
+  std::vector<llvm::BasicBlock *> blocks;
+  llvm::DenseMap<const llvm::BasicBlock *, unsigned> blockIndex;
+  std::vector<uint32_t> succOffsets;
+  std::vector<uint32_t> succs;
+  bool uniqueSuccessors;
+  // Per edge; empty unless successors are unique
+  std::vector<uint32_t> edgeMultiplicity;
+  // Per edge; empty unless pruning dropped edges, which shifts edges against
+  // successor slots
+  std::vector<uint32_t> edgeSlots;
+  unsigned numPrunedEdges = 0;
+  // Blocks of node i are chainBlocks[chainOffsets[i], chainOffsets[i + 1]);
+  // both empty without superblocks
+  std::vector<uint32_t> chainOffsets;
+  std::vector<llvm::BasicBlock *> chainBlocks;
+};
+
+} // namespace hepf
+
+#endif // CFG_INDEX_H
@@ -0,0 +1,31 @@
+#ifndef CHAIN_SUMMARY_H
+#define CHAIN_SUMMARY_H
+
+#include "CFGIndex.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/InstrTypes.h"
+#include <vector>
+
+namespace hepf {
+
+// Metrics of one CFGIndex node, summed over the blocks of its chain. With
+// superblocks a path-based pass adds up one summary per stored node instead
+// of walking every block of every path again.
+struct ChainSummary {
+  unsigned numInstructions = 0;
+  // Net change of the critical section depth over the chain
+  int lockDelta = 0;
+  // Calls in execution order
+  std::vector<llvm::CallBase *> calls;
+};
+
+// One summary per node of CFG. getLockDelta gives the lock depth change of a
+// single block, which is pass-specific.
+std::vector<ChainSummary>
+summarizeChains(const CFGIndex &CFG,
+                llvm::function_ref<int(llvm::BasicBlock *)> getLockDelta);
+
+} // namespace hepf
+
+#endif // CHAIN_SUMMARY_H
@@ -0,0 +1,84 @@
+#ifndef ENUMERATION_BUDGET_H
+#define ENUMERATION_BUDGET_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <optional>
+#include <tuple>
+
+namespace hepf {
+
+// The limit that stopped a path enumeration early
+enum class BudgetLimit { None, Paths, Time, Memory, Coverage };
+
+// Per-function limits of a path enumeration. Besides the path count and the
+// loop bound, the enumeration can be given a wall-clock and a memory budget,
+// so that one function with huge paths cannot stall a whole opt run; a
+// budget of 0 is unlimited. When any limit trips, the enumeration stops and
+// keeps the paths found so far, which are a prefix of the full enumeration.
+//
+// uniqueSuccessors enumerates over a CFGIndex with merged duplicate edges
+// (see CFGIndex), so switch cases sharing a target yield one path instead of
+// one per case. superblocks enumerates over chain nodes (single-entry,
+// single-exit runs of blocks, see CFGIndex) and expands them only when a
+// path is read back.
+//
+// pruneCold leaves out the paths that end in noreturn or cold code (see
+// CFGIndex); the counts of pruned paths are reported separately.
+//
+// A coverage in (0, 1] switches to best-first enumeration (see
+// BestFirstPathEnumerator): paths come out in order of decreasing branch
+// probability, and the enumeration stops once they cover that fraction of
+// the probability mass.
+//
+// threads enumerates DFS subtrees in parallel (see ParallelPathEnumerator);
+// 0 is one thread per hardware thread. It is opt-in, since starting threads
+// costs more than most functions take to enumerate, and it does not change
+// the paths, so budgets that differ only in threads compare equal.
+struct EnumerationBudget {
+  size_t maxPaths;
+  size_t maxLoopIterations;
+  uint64_t timeMs = 0;
+  uint64_t memBytes = 0;
+  bool uniqueSuccessors = false;
+  bool superblocks = false;
+  bool pruneCold = false;
+  double coverage = 0.0;
+  unsigned numThreads = 1;
+
+  // Apply pipeline parameters on top of this budget. The parameters are
+  // ';'-separated key=value pairs or flags:
+  //   max-paths=N;max-loop-iterations=N;time-ms=N;mem-mb=N;unique-successors;
+  //   superblocks;prune-cold;coverage=F;threads=N
+  // Returns std::nullopt for unknown keys or malformed values.
+  std::optional<EnumerationBudget> parse(llvm::StringRef params) const;
+
+  bool isBestFirst() const { return coverage > 0.0; }
+
+  // Print the setting behind a limit in pipeline syntax, e.g. "time-ms=100"
+  void print(llvm::raw_ostream &OS, BudgetLimit limit) const;
+  // Marker for partial results, e.g. "Time budget reached (time-ms=100)"
+  void printLimitReached(llvm::raw_ostream &OS, BudgetLimit limit) const;
+
+  bool operator<(const EnumerationBudget &other) const {
+    return std::tie(maxPaths, maxLoopIterations, timeMs, memBytes,
+                    uniqueSuccessors, superblocks, pruneCold, coverage) <
+           std::tie(other.maxPaths, other.maxLoopIterations, other.timeMs,
+                    other.memBytes, other.uniqueSuccessors, other.superblocks,
+                    other.pruneCold, other.coverage);
+  }
+};
+
+// "Path limit", "Time budget", "Memory budget" or "Coverage target"
+llvm::StringRef getBudgetLimitName(BudgetLimit limit);
+
+// Match a pipeline element against a pass name. LLVM 14 hands parameterized
+// names such as "pass<params>" to plugins in one piece; on a match the text
+// between the angle brackets is returned in 'params'.
+bool matchPassName(llvm::StringRef name, llvm::StringRef passName,
+                   llvm::StringRef &params);
+
+} // namespace hepf
+
+#endif // ENUMERATION_BUDGET_H
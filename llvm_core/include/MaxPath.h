@@ -1,15 +1,57 @@
 #ifndef MAX_PATH_PASS_H
 #define MAX_PATH_PASS_H
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/PassManager.h"
+#include <optional>
 
 namespace llvm {
 
 class MaxPathPass : public PassInfoMixin<MaxPathPass> {
 public:
+  // Precision tiers of the memory dependence edges, cheapest first. Memory
+  // edges run from earlier to later instructions in layout order in every
+  // tier: loop-carried memory edges are never built, as in the full scan.
+  // Hence UseDef <= MemorySSA <= DependenceInfo.
+  enum class Precision {
+    // SSA use-def edges only, in linear time: a lower bound of the others
+    UseDef,
+    // MemorySSA clobber and def-use chains filtered by alias analysis. Can
+    // exceed DependenceInfo where alias analysis cannot separate accesses
+    // that DependenceInfo can.
+    AliasAnalysis,
+    // As AliasAnalysis, with every (forward) edge confirmed by the full
+    // scan's DependenceInfo query. DependenceInfo does not refine
+    // loop-carried edges here: there are none to refine. The DependenceInfo
+    // queries are linear in the MemorySSA edges instead of quadratic.
+    MemorySSA,
+    // DependenceInfo query against every later memory instruction
+    DependenceInfo,
+    // Bound DependenceInfo's result in linear time first, and report the
+    // use-def lower bound for functions whose upper bound is below the
+    // threshold instead of running DependenceInfo
+    Auto,
+  };
+
+  struct Options {
+    Precision precision = Precision::DependenceInfo;
+    // Reporting threshold of Auto, which requires one
+    unsigned threshold = 0;
+
+    // Apply pipeline parameters on top of these options: ';'-separated
+    // usedef, aa, memoryssa, full or auto, and threshold=N (N >= 1) with
+    // auto. Returns std::nullopt for unknown or malformed parameters, a
+    // threshold without auto and auto without a threshold.
+    std::optional<Options> parse(StringRef Params) const;
+  };
+
   MaxPathPass() = default;
+  explicit MaxPathPass(Options Opts) : Opts(Opts) {}
 
   PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+
+private:
+  Options Opts;
 };
 
 } // namespace llvm
@@ -0,0 +1,64 @@
+#ifndef PARALLEL_PATH_ENUMERATOR_H
+#define PARALLEL_PATH_ENUMERATOR_H
+
+#include "CFGIndex.h"
+#include "EnumerationBudget.h"
+#include "PathEnumerator.h"
+#include "PathStore.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hepf {
+
+// Multi-threaded path enumeration with the same result as a sequential
+// PathStream using the same limits: the same paths, in the same order.
+//
+// The DFS tree is split at branch points into subtree tasks (prefixes of the
+// enumeration, kept in DFS order) that run on a work-stealing pool. Every task
+// collects its paths into its own PathStore. Tasks are merged in order, so
+// the result is deterministic. A task is abandoned once the paths of all
+// earlier tasks already exceed maxPaths, which is tracked with atomics.
+//
+// Time and memory budgets apply to the enumeration as a whole. When one
+// trips, all tasks stop and the result is the in-order prefix of the tasks up
+// to the first one that did not finish, so it is still a prefix of the
+// sequential enumeration.
+//
+// How the speedup grows with the number of cores has not been measured: the
+// scaling table of bench/bench_path_enumerator.cpp has only been run on a
+// single core, where 2 threads are at parity with the sequential engine.
+class ParallelPathEnumerator {
+public:
+  // numThreads = 0 uses one thread per hardware thread
+  ParallelPathEnumerator(std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+                         size_t maxLoopIterations, unsigned numThreads);
+  ParallelPathEnumerator(std::shared_ptr<const CFGIndex> CFG,
+                         const EnumerationBudget &budget, unsigned numThreads);
+
+  PathStore run();
+
+  // True if more than maxPaths paths exist
+  bool hasReachedLimit() const { return limitHit == BudgetLimit::Paths; }
+  // Which limit, if any, cut the enumeration short
+  BudgetLimit getLimitHit() const { return limitHit; }
+  size_t getNumTasks() const { return numTasks; }
+  unsigned getNumThreads() const { return numThreads; }
+
+private:
+  std::vector<std::vector<uint32_t>> splitIntoTasks(size_t targetTasks) const;
+  bool extendChain(std::vector<uint32_t> &prefix) const;
+
+  std::shared_ptr<const CFGIndex> CFG;
+  size_t maxPaths;
+  size_t maxLoopIterations;
+  uint64_t timeMs;
+  uint64_t memBytes;
+  unsigned numThreads;
+  size_t numTasks;
+  BudgetLimit limitHit;
+};
+
+} // namespace hepf
+
+#endif // PARALLEL_PATH_ENUMERATOR_H
@@ -0,0 +1,248 @@
+#ifndef PATH_ALGEBRA_H
+#define PATH_ALGEBRA_H
+
+#include "CFGIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/BasicBlock.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hepf {
+
+// Path metrics by dynamic programming over the CFG instead of per path.
+//
+// A path metric is the sum of a per-block number, BlockSummary(BB), along the
+// path; the Semiring says what to keep of it over a set of paths:
+//   Value lift(double metric)        a single block
+//   Value edge(BasicBlock *, BasicBlock *)  a CFG edge (its weight)
+//   Value concat(Value, Value)       paths followed by paths
+//   Value join(Value, Value)         either set of paths
+// The result is exact when concat distributes over join, e.g. (max, +) for
+// the longest path or (+, *) for path counts. solve() computes the value
+// over all entry-to-exit paths with
+// the loop bound of PathCounter: a forward DP over each loop body in reverse
+// post-order, innermost loops first and collapsed into their headers, with
+// 0..maxLoopIterations iterations per entry of a loop composed by Horner's
+// scheme. That is O(V + E) semiring operations plus the loop bound per loop
+// exit, however many paths there are. As in PathCounter, retreating edges of
+// irreducible CFGs are ignored.
+template <typename Semiring, typename BlockSummary> class PathAlgebra {
+public:
+  using Value = typename Semiring::Value;
+
+  PathAlgebra(Semiring S, BlockSummary summary)
+      : S(std::move(S)), summary(std::move(summary)) {}
+
+  Value block(llvm::BasicBlock *BB) const { return S.lift(summary(BB)); }
+  Value edge(llvm::BasicBlock *Src, llvm::BasicBlock *Dst) const {
+    return S.edge(Src, Dst);
+  }
+  Value concat(const Value &A, const Value &B) const {
+    return S.concat(A, B);
+  }
+  Value join(const Value &A, const Value &B) const { return S.join(A, B); }
+
+  // Value of all entry-to-exit paths over the nodes of CFG (chains with
+  // superblocks). Returns std::nullopt if the function has no complete path.
+  std::optional<Value> solve(const CFGIndex &CFG, llvm::LoopInfo &LI,
+                             size_t maxLoopIterations) const;
+
+private:
+  // Paths of one loop (or of the function body), from just after its header
+  // block: once around to the header again, to a block ending inside, and
+  // up to the edge into each exit block
+  struct Summary {
+    std::optional<Value> cycles;
+    std::optional<Value> terminating;
+    llvm::SmallVector<std::pair<uint32_t, Value>, 4> exits;
+  };
+
+  void accumulate(std::optional<Value> &slot, const Value &value) const {
+    slot = slot ? S.join(*slot, value) : value;
+  }
+
+  Semiring S;
+  BlockSummary summary;
+};
+
+template <typename Semiring, typename BlockSummary>
+std::optional<typename PathAlgebra<Semiring, BlockSummary>::Value>
+PathAlgebra<Semiring, BlockSummary>::solve(const CFGIndex &CFG,
+                                           llvm::LoopInfo &LI,
+                                           size_t maxLoopIterations) const {
+  if (CFG.empty())
+    return std::nullopt;
+  const unsigned numNodes = CFG.size();
+
+  // A node stands for its chain of blocks and the edges between them
+  std::vector<Value> nodeValues;
+  nodeValues.reserve(numNodes);
+  for (unsigned node = 0; node < numNodes; ++node) {
+    llvm::ArrayRef<llvm::BasicBlock *> chain = CFG.getChain(node);
+    Value value = block(chain[0]);
+    for (size_t i = 1; i < chain.size(); ++i)
+      value = concat(concat(value, edge(chain[i - 1], chain[i])),
+                     block(chain[i]));
+    nodeValues.push_back(value);
+  }
+  if (CFG.isExit(0))
+    return nodeValues[0];
+
+  constexpr uint32_t Unreachable = UINT32_MAX;
+  std::vector<uint32_t> rpo = CFG.getReversePostOrder();
+  std::vector<uint32_t> rpoNumber(numNodes, Unreachable);
+  for (uint32_t i = 0; i < rpo.size(); ++i)
+    rpoNumber[rpo[i]] = i;
+
+  llvm::DenseMap<const llvm::Loop *, Summary> loopSummaries;
+  auto summarize = [&](llvm::Loop *L) {
+    Summary Sum;
+    std::vector<uint32_t> nodes;
+    if (L) {
+      for (llvm::BasicBlock *BB : L->blocks()) {
+        uint32_t node = CFG.getIndex(BB);
+        if (CFG.getBlock(node) == BB && rpoNumber[node] != Unreachable)
+          nodes.push_back(node);
+      }
+      llvm::sort(nodes, [&](uint32_t a, uint32_t b) {
+        return rpoNumber[a] < rpoNumber[b];
+      });
+    } else {
+      nodes = rpo;
+    }
+
+    const uint32_t header = L ? CFG.getIndex(L->getHeader()) : 0;
+    // Paths from just after the header block up to the edge into a node
+    llvm::DenseMap<uint32_t, Value> pending;
+    auto route = [&](uint32_t from, uint32_t to, const Value &value) {
+      if (L && to == header) {
+        accumulate(Sum.cycles, concat(value, nodeValues[header]));
+      } else if (L && !L->contains(CFG.getBlock(to))) {
+        auto It = llvm::find_if(
+            Sum.exits, [&](const auto &E) { return E.first == to; });
+        if (It == Sum.exits.end())
+          Sum.exits.emplace_back(to, value);
+        else
+          It->second = join(It->second, value);
+      } else if (rpoNumber[to] > rpoNumber[from]) {
+        auto [It, inserted] = pending.try_emplace(to, value);
+        if (!inserted)
+          It->second = join(It->second, value);
+      }
+    };
+
+    for (uint32_t node : nodes) {
+      // Paths from just after the header through this node; none for the
+      // header itself, where they are empty
+      std::optional<Value> through;
+      if (node != header) {
+        auto It = pending.find(node);
+        if (It == pending.end())
+          continue;
+        through = concat(It->second, nodeValues[node]);
+      }
+      auto extend = [&](const Value &value) {
+        return through ? concat(*through, value) : value;
+      };
+
+      llvm::Loop *Inner = LI.getLoopFor(CFG.getBlock(node));
+      if (Inner != L) {
+        // Paths can only enter a nested loop through the header of the
+        // outermost such loop
+        while (Inner->getParentLoop() != L)
+          Inner = Inner->getParentLoop();
+        if (CFG.getIndex(Inner->getHeader()) != node)
+          continue;
+        const Summary &IS = loopSummaries[Inner];
+        if (IS.terminating)
+          accumulate(Sum.terminating, extend(*IS.terminating));
+        for (const auto &[target, value] : IS.exits)
+          route(node, target, extend(value));
+        continue;
+      }
+
+      if (CFG.isExit(node)) {
+        if (through)
+          accumulate(Sum.terminating, *through);
+        continue;
+      }
+      llvm::BasicBlock *Last = CFG.getChain(node).back();
+      for (uint32_t succ : CFG.successors(node))
+        route(node, succ, extend(edge(Last, CFG.getBlock(succ))));
+    }
+
+    // Every path out of the loop runs 0..maxLoopIterations cycles first
+    if (Sum.cycles) {
+      auto iterate = [&](Value &value) {
+        Value total = value;
+        for (size_t k = 0; k < maxLoopIterations; ++k)
+          total = join(value, concat(*Sum.cycles, total));
+        value = total;
+      };
+      if (Sum.terminating)
+        iterate(*Sum.terminating);
+      for (auto &E : Sum.exits)
+        iterate(E.second);
+    }
+    return Sum;
+  };
+
+  // Innermost loops first
+  llvm::SmallVector<llvm::Loop *, 8> loops = LI.getLoopsInPreorder();
+  for (llvm::Loop *L : llvm::reverse(loops)) {
+    Summary Sum = summarize(L);
+    loopSummaries[L] = std::move(Sum);
+  }
+  Summary Body = summarize(nullptr);
+  if (!Body.terminating)
+    return std::nullopt;
+  return concat(nodeValues[0], *Body.terminating);
+}
+
+// Number, extremes and moments of the metric over a set of paths: min, max,
+// mean and variance of e.g. the path length in one DP pass. Counts are
+// doubles, so they do not overflow where the number of paths explodes.
+struct PathStatistics {
+  struct Value {
+    double count;
+    double min;
+    double max;
+    double sum;
+    double sumSquares;
+
+    double mean() const { return sum / count; }
+    double variance() const {
+      return std::max(0.0, sumSquares / count - mean() * mean());
+    }
+  };
+
+  Value lift(double metric) const {
+    return {1.0, metric, metric, metric, metric * metric};
+  }
+  Value edge(llvm::BasicBlock *, llvm::BasicBlock *) const {
+    return {1.0, 0.0, 0.0, 0.0, 0.0};
+  }
+  // Every path of A followed by every path of B: (a + b)^2 summed over the
+  // pairs expands into the sums and squares of both sides
+  Value concat(const Value &A, const Value &B) const {
+    return {A.count * B.count, A.min + B.min, A.max + B.max,
+            A.sum * B.count + A.count * B.sum,
+            A.sumSquares * B.count + 2.0 * A.sum * B.sum +
+                A.count * B.sumSquares};
+  }
+  Value join(const Value &A, const Value &B) const {
+    return {A.count + B.count, std::min(A.min, B.min), std::max(A.max, B.max),
+            A.sum + B.sum, A.sumSquares + B.sumSquares};
+  }
+};
+
+} // namespace hepf
+
+#endif // PATH_ALGEBRA_H
@@ -1,6 +1,7 @@
 #ifndef LLVM_CORE_PATHBASEDCRITICALSECTIONTRAVERSAL_H
 #define LLVM_CORE_PATHBASEDCRITICALSECTIONTRAVERSAL_H
 
+#include "EnumerationBudget.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
 
@@ -11,8 +12,7 @@ struct PathBasedCriticalSectionTraversalPass
 
 private:
   // 1. Declare members to hold the configuration values
-  const size_t MaxPaths;
-  const size_t MaxLoopIterations;
+  const EnumerationBudget Budget;
 
 public:
   // 2. Constructor: Use the struct name and accept the parameters.
@@ -20,7 +20,10 @@ public:
   explicit PathBasedCriticalSectionTraversalPass(
       size_t maxPaths,
       size_t maxLoopIterations);
-  PathBasedCriticalSectionTraversalPass() : MaxPaths(100), MaxLoopIterations(100) {};
+  explicit PathBasedCriticalSectionTraversalPass(
+      const EnumerationBudget &budget)
+      : Budget(budget) {}
+  PathBasedCriticalSectionTraversalPass() : Budget{100, 100} {};
 
   // The run method uses the configuration data stored in the struct members.
   llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "PathEnumeratorAnalysis.h"
 #include "llvm/IR/PassManager.h"
 
 namespace llvm {
 class BranchProbabilityInfo;
 class Function;
+class LoopInfo;
 } // namespace llvm
 
 namespace hepf {
@@ -13,12 +15,13 @@ class PathBasedFlowDensityPass
     : public llvm::PassInfoMixin<PathBasedFlowDensityPass> {
 
 private:
-    const size_t MaxPaths;
-    const size_t MaxLoopIterations;
+    const EnumerationBudget Budget;
 
 public:
   explicit PathBasedFlowDensityPass(size_t maxPaths, size_t maxLoopIterations);
-  PathBasedFlowDensityPass() : MaxPaths(100), MaxLoopIterations(100) {};
+  explicit PathBasedFlowDensityPass(const EnumerationBudget &budget)
+      : Budget(budget) {}
+  PathBasedFlowDensityPass() : Budget{100, 100} {};
 
   // Module-level entry point required by the new PM
   llvm::PreservedAnalyses run(llvm::Module &M,
@@ -26,7 +29,9 @@ public:
 
   // Helper that does the real work on a single function
   // (declared here so we can call it from run())
-  void runOnFunction(llvm::Function &F, llvm::BranchProbabilityInfo &BPI);
+  void runOnFunction(llvm::Function &F, llvm::BranchProbabilityInfo &BPI,
+                     PathEnumeratorAnalysis::Result &Paths,
+                     llvm::LoopInfo &LI);
 
   // Optional: makes the pass show up in -print-pass-names / opt -passes=
   static bool isRequired() { return true; }
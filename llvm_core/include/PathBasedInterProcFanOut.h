@@ -1,6 +1,7 @@
 #ifndef LLVM_CORE_PATHBASEDINTERPROCFANOUT_H
 #define LLVM_CORE_PATHBASEDINTERPROCFANOUT_H
 
+#include "EnumerationBudget.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
 
@@ -8,6 +9,17 @@ namespace hepf {
 
 struct PathBasedInterProcFanOutPass
     : public llvm::PassInfoMixin<PathBasedInterProcFanOutPass> {
+  // Limits of the per-function path enumeration. A single loop iteration
+  // keeps fan-out analysis from exploding.
+  EnumerationBudget Budget;
+  // Evaluate every path on its own instead of in bit-parallel batches or
+  // incrementally along the enumeration tree; slower, for cross-checking
+  bool PerPath = false;
+
+  explicit PathBasedInterProcFanOutPass(
+      const EnumerationBudget &budget = {5000, 1})
+      : Budget(budget) {}
+
   llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
 };
 
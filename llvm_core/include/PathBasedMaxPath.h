@@ -1,12 +1,19 @@
 #ifndef LLVM_CORE_PATHBASEDMAXPATH_H
 #define LLVM_CORE_PATHBASEDMAXPATH_H
 
+#include "EnumerationBudget.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
 
 namespace hepf {
 
 struct PathBasedMaxPathPass : public llvm::PassInfoMixin<PathBasedMaxPathPass> {
+  // Limits of the per-function path enumeration
+  EnumerationBudget Budget;
+
+  explicit PathBasedMaxPathPass(const EnumerationBudget &budget = {5000, 1})
+      : Budget(budget) {}
+
   llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
 };
 
@@ -0,0 +1,116 @@
+#ifndef PATH_COUNTER_H
+#define PATH_COUNTER_H
+
+#include "CFGIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <vector>
+
+namespace hepf {
+
+// Counts the paths PathEnumerator would produce, in time linear in the CFG,
+// without enumerating them.
+//
+// Loops are summarized innermost first. For a loop L, a forward DP over its
+// body in reverse post-order (inner loops already collapsed) gives the number
+// C of one-iteration paths from the header back to the header, and the number
+// of paths from the header to each exit. With the header entered at most
+// maxLoopIterations + 1 times, every exit path can be preceded by
+// 0..maxLoopIterations cycles, so the loop multiplies its exits by
+// 1 + C + ... + C^maxLoopIterations. The same DP over the function with the
+// top-level loops collapsed yields the total.
+//
+// The count is exact for reducible CFGs without nested loops. With nested
+// loops PathEnumerator bounds inner block visits over the whole path rather
+// than per outer iteration, so the count is an upper bound. On irreducible
+// CFGs retreating edges into the middle of a cycle are ignored and the count
+// is neither.
+class PathCounter {
+public:
+  // uniqueSuccessors counts over merged duplicate edges, as an enumeration
+  // with EnumerationBudget::uniqueSuccessors produces them. pruneCold counts
+  // the paths left by EnumerationBudget::pruneCold, and the pruned ones
+  // separately.
+  PathCounter(llvm::Function &F, llvm::LoopInfo &LI, size_t maxLoopIterations,
+              bool uniqueSuccessors = false, bool pruneCold = false);
+
+  // Number of paths, saturating at UINT64_MAX
+  uint64_t getNumPaths() const { return numPaths; }
+  bool hasOverflowed() const { return overflowed; }
+  bool isExact() const { return exact; }
+  // True if the count is at least the number of enumerated paths
+  bool isUpperBound() const { return upperBound; }
+
+  bool isPruning() const { return pruning; }
+  // Paths through cold or noreturn code left out of getNumPaths(), with the
+  // precision of the counts; at least this many if the full count overflowed
+  uint64_t getNumPrunedPaths() const { return numPrunedPaths; }
+
+private:
+  // Path counts of one loop (or of the function body for L = nullptr)
+  struct Summary {
+    // One-iteration paths from the header back to the header
+    uint64_t cycles = 0;
+    // Paths ending inside the body (returns, unreachable)
+    uint64_t terminating = 0;
+    // Paths leaving the body, by target block
+    llvm::SmallVector<std::pair<uint32_t, uint64_t>, 4> exits;
+  };
+
+  Summary summarize(llvm::Loop *L);
+  void expandIterations(Summary &S);
+  uint64_t add(uint64_t a, uint64_t b);
+  uint64_t mul(uint64_t a, uint64_t b);
+
+  CFGIndex CFG;
+  llvm::LoopInfo &LI;
+  size_t maxLoopIterations;
+  std::vector<uint32_t> rpo;
+  std::vector<uint32_t> rpoNumber;
+  llvm::DenseMap<const llvm::Loop *, Summary> loopSummaries;
+
+  uint64_t numPaths;
+  uint64_t numPrunedPaths;
+  bool pruning;
+  bool overflowed;
+  bool exact;
+  bool upperBound;
+};
+
+// Per-function choice between enumerating, sampling and skipping, made from
+// the path count before any path is produced. With bestFirst, functions over
+// the limit are enumerated most probable path first instead of sampled.
+// Passes that cover every path by a DP over the CFG instead use
+// withoutSampling(): over the limit they only report the DP. Passes that list
+// the first maxPaths paths in enumeration order use truncating().
+struct EnumerationPlan {
+  enum Mode { Exhaustive, Sampled, Skipped, BestFirst, Summarized, Truncated };
+
+  Mode mode;
+  const PathCounter &counter;
+  size_t maxPaths;
+
+  static EnumerationPlan choose(const PathCounter &counter, size_t maxPaths,
+                                bool bestFirst = false);
+  // The same plan with Summarized in place of Sampled
+  EnumerationPlan withoutSampling() const {
+    return {mode == Sampled ? Summarized : mode, counter, maxPaths};
+  }
+  // The same plan with Truncated in place of Sampled
+  EnumerationPlan truncating() const {
+    return {mode == Sampled ? Truncated : mode, counter, maxPaths};
+  }
+  // True if the plan enumerates paths with a PathEnumerator
+  bool enumerates() const {
+    return mode == Exhaustive || mode == BestFirst || mode == Truncated;
+  }
+  // e.g. "sampled (at least 18446744073709551615 paths > limit 5000)"
+  void print(llvm::raw_ostream &OS) const;
+};
+
+} // namespace hepf
+
+#endif // PATH_COUNTER_H
@@ -1,14 +1,132 @@
 #ifndef PATH_ENUMERATOR_H
 #define PATH_ENUMERATOR_H
 
+#include "CFGIndex.h"
+#include "EnumerationBudget.h"
+#include "PathStore.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
-#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <vector>
 
 namespace hepf {
 
-using Path = std::vector<llvm::BasicBlock *>;
+// Pull-based depth-first path generator.
+//
+// Each call to next() resumes the DFS where the previous one stopped and
+// leaves the next complete entry-to-exit path in currentView(). The path lives
+// in a single reusable buffer that is only valid until the following next(), so
+// memory stays proportional to the CFG depth rather than to the number of
+// paths, and consumers can stop at any point.
+//
+// The DFS runs on the dense block numbering of a CFGIndex: the stack is a
+// contiguous array of block indices (which doubles as the current path) with a
+// parallel array of successor cursors, and loop iterations are counted in a
+// per-block array, so a step costs no hashing and no native stack.
+class PathStream {
+public:
+  PathStream(llvm::Function &F, size_t maxPaths, size_t maxLoopIterations);
+  PathStream(std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+             size_t maxLoopIterations);
+  // Only enumerate the subtree of paths starting with 'prefix' (a sequence of
+  // CFGIndex block numbers beginning at the entry block)
+  PathStream(std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+             size_t maxLoopIterations, llvm::ArrayRef<uint32_t> prefix);
+
+  // Print a warning when the path limit cuts the enumeration short
+  void setWarnOnLimit(bool warn) { warnOnLimit = warn; }
+  // Stop the enumeration once this point in time has passed
+  void setDeadline(std::chrono::steady_clock::time_point deadline);
+
+  // Advance to the next path. Returns false once enumeration is finished.
+  bool next();
+  // The current path as a view into the stream's buffer
+  PathView currentView() const { return PathView(*CFG, pathBlocks); }
+  llvm::ArrayRef<uint32_t> currentIndices() const { return pathBlocks; }
+  // The current path as BasicBlock pointers, built on first use per path
+  const Path &current() const;
+
+  // True if more than maxPaths paths exist
+  bool hasReachedLimit() const { return reachedLimit; }
+  // True if the deadline stopped the enumeration
+  bool hasExpired() const { return expired; }
+  // Number of paths produced so far
+  size_t getPathCount() const { return pathCount; }
+
+  // Number of leading blocks the current path shares with the previous one
+  size_t getSharedPrefixLength() const { return sharedPrefix; }
+  // CFGIndex block number of the i'th block of the current path
+  uint32_t currentBlockIndex(size_t i) const { return pathBlocks[i]; }
+  const std::shared_ptr<const CFGIndex> &getCFG() const { return CFG; }
+
+  // Input iterator so that a stream can be used in a range-based for loop
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = PathView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = PathView;
+
+    iterator() : stream(nullptr) {}
+    explicit iterator(PathStream *stream) : stream(stream) { advance(); }
+
+    reference operator*() const { return stream->currentView(); }
+    iterator &operator++() {
+      advance();
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return stream == other.stream;
+    }
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+
+  private:
+    void advance() {
+      if (stream && !stream->next())
+        stream = nullptr;
+    }
+
+    PathStream *stream;
+  };
+
+  iterator begin() { return iterator(this); }
+  iterator end() { return iterator(); }
+
+private:
+  bool enter(uint32_t block);
+  void leave();
+  bool checkDeadline();
+
+  std::shared_ptr<const CFGIndex> CFG;
+  size_t maxPaths;
+  size_t maxLoopIterations;
+
+  // DFS stack: the blocks of the current path and, for each of them, the
+  // next outgoing edge to explore
+  std::vector<uint32_t> pathBlocks;
+  std::vector<uint32_t> nextEdges;
+  mutable Path currentPath;
+  mutable bool currentPathValid;
+  std::vector<uint32_t> visitCount;
+  size_t pathCount;
+  size_t sharedPrefix;
+  bool started;
+  bool finished;
+  bool reachedLimit;
+  bool warnOnLimit;
+
+  // Reading the clock on every DFS step would dominate a step, so it is
+  // read every DeadlineCheckInterval steps
+  static constexpr unsigned DeadlineCheckInterval = 1024;
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  unsigned stepsUntilCheck;
+  bool expired;
+};
 
 class PathEnumerator {
 public:
@@ -17,23 +135,57 @@ public:
   // bodies)
   explicit PathEnumerator(llvm::Function &F, size_t maxPaths,
                           size_t maxLoopIterations);
+  // Enumerate over an existing index of F's CFG
+  PathEnumerator(llvm::Function &F, std::shared_ptr<const CFGIndex> CFG,
+                 size_t maxPaths, size_t maxLoopIterations);
+  // Enumerate with time and memory budgets in addition to the path limit
+  PathEnumerator(llvm::Function &F, std::shared_ptr<const CFGIndex> CFG,
+                 const EnumerationBudget &budget);
+
+  // Lazily enumerate the paths one at a time
+  PathStream stream() const;
+  const std::shared_ptr<const CFGIndex> &getCFG() const { return CFG; }
+  size_t getMaxLoopIterations() const { return budget.maxLoopIterations; }
+  const EnumerationBudget &getBudget() const { return budget; }
+
+  // Let the compatibility wrappers below enumerate with this many threads
+  // (0 = one per hardware thread). The paths and their order do not change.
+  void setNumThreads(unsigned threads) { numThreads = threads; }
+  // Branch probabilities for best-first budgets, one per CFGIndex edge (see
+  // CFGIndex::getEdgeProbabilities). Without them best-first enumeration
+  // takes the successors of a block with equal probability.
+  void setEdgeProbabilities(std::vector<double> probabilities) {
+    edgeProbabilities = std::move(probabilities);
+  }
 
+  // The first call drains the enumeration into a compact PathStore
+  const PathStore &getPathStore() const;
+
+  // Compatibility wrappers over getPathStore()
   const std::vector<Path> &getPaths() const;
-  bool hasReachedLimit() const { return reachedLimit; }
-  size_t getPathCount() const { return paths.size(); }
+  bool hasReachedLimit() const;
+  size_t getPathCount() const;
+  // Which limit, if any, cut the enumeration short
+  BudgetLimit getLimitHit() const;
+  // Probability mass of the enumerated paths; only tracked by best-first
+  // enumeration
+  double getCoveredProbability() const;
 
 private:
-  void findAllPaths(llvm::BasicBlock *current,
-                    std::vector<llvm::BasicBlock *> &currentPath,
-                    std::unordered_map<llvm::BasicBlock *, size_t> &visitCount);
-
-  bool isExitBlock(llvm::BasicBlock *BB) const;
+  void drain() const;
 
   llvm::Function &F;
-  std::vector<Path> paths;
-  size_t maxPaths;
-  size_t maxLoopIterations;
-  bool reachedLimit;
+  std::shared_ptr<const CFGIndex> CFG;
+  EnumerationBudget budget;
+  unsigned numThreads;
+  std::vector<double> edgeProbabilities;
+
+  mutable PathStore store;
+  mutable std::vector<Path> paths;
+  mutable bool drained;
+  mutable bool materialized;
+  mutable BudgetLimit limitHit;
+  mutable double coveredProbability;
 };
 
 } // namespace hepf
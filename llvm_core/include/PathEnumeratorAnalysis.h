@@ -0,0 +1,78 @@
+#ifndef PATH_ENUMERATOR_ANALYSIS_H
+#define PATH_ENUMERATOR_ANALYSIS_H
+
+#include "CFGIndex.h"
+#include "EnumerationBudget.h"
+#include "PathEnumerator.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/PassManager.h"
+#include <map>
+#include <memory>
+
+namespace hepf {
+
+// Function analysis that caches path enumerations so that several path-based
+// passes in one pipeline share them.
+//
+// The result holds one PathEnumerator per EnumerationBudget that has been
+// asked for, sharing one CFGIndex per index mode. Each enumeration runs
+// on its first request and is kept until the CFG of the function changes
+// (prune-cold ones: until the function changes at all).
+//
+// Sharing means keeping: a cached enumeration holds all of its paths in a
+// PathStore (compact, but up to maxPaths paths per budget) for as long as
+// the function's CFG lives, where a pass streaming its own PathEnumerator
+// holds one path at a time. Passes that need constant memory can still
+// build a PathEnumerator and use stream().
+class PathEnumeratorAnalysis
+    : public llvm::AnalysisInfoMixin<PathEnumeratorAnalysis> {
+  friend llvm::AnalysisInfoMixin<PathEnumeratorAnalysis>;
+  static llvm::AnalysisKey Key;
+
+public:
+  class Result {
+  public:
+    explicit Result(llvm::Function &F);
+
+    // Enumeration of the function with the given limits; the paths are
+    // enumerated on the first getPathStore() call of the returned object
+    const PathEnumerator &get(size_t maxPaths, size_t maxLoopIterations);
+    // Best-first budgets order the paths by BPI's probabilities, or by
+    // uniform ones without BPI
+    const PathEnumerator &
+    get(const EnumerationBudget &budget,
+        const llvm::BranchProbabilityInfo *BPI = nullptr);
+    // As above, taking BPI from FAM when the budget is best-first
+    const PathEnumerator &get(const EnumerationBudget &budget,
+                              llvm::FunctionAnalysisManager &FAM);
+
+    // Index of the function's CFG; the variants with merged successors,
+    // superblocks or pruned cold paths are built on first use
+    const std::shared_ptr<const CFGIndex> &
+    getCFG(bool uniqueSuccessors = false, bool superblocks = false,
+           bool pruneCold = false);
+    // The index an enumeration with this budget runs on
+    const std::shared_ptr<const CFGIndex> &
+    getCFG(const EnumerationBudget &budget);
+    // Number of distinct budgets requested so far
+    size_t getNumEnumerations() const { return enumerations.size(); }
+
+    // Paths only depend on the CFG, so the result survives any pass that
+    // preserves CFGAnalyses, less the prune-cold indexes and enumerations,
+    // which also depend on calls and branch weights
+    bool invalidate(llvm::Function &F, const llvm::PreservedAnalyses &PA,
+                    llvm::FunctionAnalysisManager::Invalidator &);
+
+  private:
+    llvm::Function *F;
+    // Indexed by uniqueSuccessors + 2 * superblocks + 4 * pruneCold
+    std::shared_ptr<const CFGIndex> CFGs[8];
+    std::map<EnumerationBudget, std::unique_ptr<PathEnumerator>> enumerations;
+  };
+
+  Result run(llvm::Function &F, llvm::FunctionAnalysisManager &);
+};
+
+} // namespace hepf
+
+#endif // PATH_ENUMERATOR_ANALYSIS_H
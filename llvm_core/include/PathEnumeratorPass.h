@@ -1,22 +1,29 @@
 #ifndef LLVM_CORE_PATHENUMERATORPASS_H
 #define LLVM_CORE_PATHENUMERATORPASS_H
 
+#include "EnumerationBudget.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
+#include <string>
 
 namespace hepf {
 
 struct PathEnumeratorPass : public llvm::PassInfoMixin<PathEnumeratorPass> {
   // 1. Store parameters as members if needed later in 'run'
-  size_t MaxPaths;
-  size_t MaxLoopIterations;
+  EnumerationBudget Budget;
+  // Directories to write the enumerated paths of every function to, as
+  // serialized PathStores, and to compare them against; empty for none
+  std::string PathsOut;
+  std::string PathsIn;
 
   // 2. Add a simple constructor to initialize the members.
   // This allows the pass to be configured when instantiated.
   explicit PathEnumeratorPass(size_t maxPaths,
                               size_t maxLoopIterations)
-      : MaxPaths(maxPaths), MaxLoopIterations(maxLoopIterations) {}
-  PathEnumeratorPass() : MaxPaths(100), MaxLoopIterations(100) {}
+      : Budget{maxPaths, maxLoopIterations} {}
+  explicit PathEnumeratorPass(const EnumerationBudget &budget)
+      : Budget(budget) {}
+  PathEnumeratorPass() : Budget{100, 100} {}
 
   // The 'run' method for a Module Pass is correct as written.
   llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
@@ -0,0 +1,165 @@
+#ifndef PATH_EXPRESSION_H
+#define PATH_EXPRESSION_H
+
+#include "CFGIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace hepf {
+
+// Regular expression over the CFG edges that denotes every entry-to-exit path
+// of a function, loops included.
+//
+// The expression is built by state elimination: every block other than the
+// entry and the exits is removed in turn, and each pair of a predecessor i
+// and a successor j of the removed block k gains the paths through it,
+//   R(i, j) += R(i, k) . R(k, k)* . R(k, j)
+// Blocks go in DFS post-order, so the blocks of an inner loop are removed
+// before its header and the loop collapses into a single starred term. The
+// expression is a DAG of hash-consed nodes: a subexpression shared by several
+// pairs is built and evaluated once, which keeps reducible CFGs close to
+// linear.
+//
+// evaluate() interprets the expression in an algebra with a Value type and
+//   block(BB)        value of a path consisting of BB alone
+//   edge(Src, Dst)   value of taking the CFG edge Src -> Dst
+//   concat(A, B)     value of path A followed by path B (associative)
+//   join(A, B)       combine the values of two alternative paths
+//   star(A)          value of taking A any number of times (0, 1, 2, ...)
+// with concat distributing over join. Where star has a closed form
+// the result covers all iterations of every loop, with no maxLoopIterations
+// bound and no per-path work.
+//
+// The expression is over the nodes and edges of a CFGIndex, so it follows
+// the index's unique successors, superblocks and pruned cold edges and
+// denotes the same paths as an enumeration over that index. Parallel edges
+// (successor slots sharing a target) are a single term: A.edge(Src, Dst)
+// stands for every slot from Src to Dst, e.g. with their total probability.
+// A superblock is evaluated as its chain of blocks and the edges within it.
+class PathExpression {
+public:
+  explicit PathExpression(std::shared_ptr<const CFGIndex> CFG);
+
+  // Interpret the expression with algebra A. Returns std::nullopt if the
+  // function has no complete path.
+  template <typename Algebra>
+  std::optional<typename Algebra::Value> evaluate(const Algebra &A) const;
+
+  // Nodes of the expression DAG reachable from the root
+  size_t size() const;
+  // Print the expression as a regular expression over edges src>dst between
+  // nodes, named by their first block (or "#n" for node n), cut
+  // after roughly maxChars characters. Subexpressions used more than once
+  // are printed once, as bindings "$1 = ...; $2 = ...;" ahead of the
+  // expression that refers to them, so shared suffixes (e.g. of a chain of
+  // diamonds) keep the output linear in the DAG.
+  void print(llvm::raw_ostream &OS, size_t maxChars = 400) const;
+
+private:
+  enum class Kind : uint8_t {
+    Edge,   // the edges (lhs, rhs) between CFGIndex nodes, then node rhs
+    Concat, // lhs followed by rhs
+    Union,  // lhs or rhs
+    Star,   // lhs, any number of times
+  };
+  struct Node {
+    Kind kind;
+    uint32_t lhs;
+    uint32_t rhs;
+  };
+  static constexpr uint32_t None = UINT32_MAX;
+
+  uint32_t make(Kind kind, uint32_t lhs, uint32_t rhs = 0);
+  // The blocks of a node and the edges between them, after entering it
+  template <typename Algebra>
+  typename Algebra::Value evaluateNode(const Algebra &A, uint32_t node) const;
+  // Nodes reachable from the root; operands precede the nodes using them
+  std::vector<bool> getReachable() const;
+  // Print a node; operands with a binding number in names print as "$n"
+  void printNode(llvm::raw_ostream &OS, uint32_t node,
+                 llvm::ArrayRef<uint32_t> names, size_t &budget) const;
+
+  std::shared_ptr<const CFGIndex> CFG;
+  std::vector<Node> nodes;
+  llvm::DenseMap<std::tuple<uint8_t, uint32_t, uint32_t>, uint32_t> uniqued;
+  // Union of all paths from the entry, excluding the entry block itself;
+  // None if no exit is reachable or the entry is the only block on its path
+  uint32_t root;
+  bool entryIsExit;
+};
+
+template <typename Algebra>
+typename Algebra::Value
+PathExpression::evaluateNode(const Algebra &A, uint32_t node) const {
+  llvm::ArrayRef<llvm::BasicBlock *> chain = CFG->getChain(node);
+  typename Algebra::Value value = A.block(chain[0]);
+  for (size_t i = 1; i < chain.size(); ++i)
+    value = A.concat(A.concat(value, A.edge(chain[i - 1], chain[i])),
+                     A.block(chain[i]));
+  return value;
+}
+
+template <typename Algebra>
+std::optional<typename Algebra::Value>
+PathExpression::evaluate(const Algebra &A) const {
+  using Value = typename Algebra::Value;
+  if (CFG->empty())
+    return std::nullopt;
+  Value entry = evaluateNode(A, 0);
+  if (entryIsExit)
+    return entry;
+  if (root == None)
+    return std::nullopt;
+
+  std::vector<bool> reachable = getReachable();
+  std::vector<std::optional<Value>> values(root + 1);
+  for (uint32_t n = 0; n <= root; ++n) {
+    if (!reachable[n])
+      continue;
+    const Node &N = nodes[n];
+    switch (N.kind) {
+    case Kind::Edge:
+      values[n] = A.concat(
+          A.edge(CFG->getChain(N.lhs).back(), CFG->getBlock(N.rhs)),
+          evaluateNode(A, N.rhs));
+      break;
+    case Kind::Concat:
+      values[n] = A.concat(*values[N.lhs], *values[N.rhs]);
+      break;
+    case Kind::Union:
+      values[n] = A.join(*values[N.lhs], *values[N.rhs]);
+      break;
+    case Kind::Star:
+      values[n] = A.star(*values[N.lhs]);
+      break;
+    }
+  }
+  return A.concat(entry, *values[root]);
+}
+
+// Number of paths, saturating at UINT64_MAX
+struct PathCountAlgebra {
+  using Value = uint64_t;
+  Value block(llvm::BasicBlock *) const { return 1; }
+  Value edge(llvm::BasicBlock *, llvm::BasicBlock *) const { return 1; }
+  Value concat(Value A, Value B) const {
+    Value result;
+    return __builtin_mul_overflow(A, B, &result) ? UINT64_MAX : result;
+  }
+  Value join(Value A, Value B) const {
+    Value result;
+    return __builtin_add_overflow(A, B, &result) ? UINT64_MAX : result;
+  }
+  // A cycle taken any number of times has no bound
+  Value star(Value A) const { return A == 0 ? 1 : UINT64_MAX; }
+};
+
+} // namespace hepf
+
+#endif // PATH_EXPRESSION_H
@@ -0,0 +1,88 @@
+#ifndef PATH_NUMBERING_H
+#define PATH_NUMBERING_H
+
+#include "CFGIndex.h"
+#include "PathEnumerator.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace hepf {
+
+// Ball-Larus path numbering over the acyclic CFG of a function.
+//
+// Back edges (found by a DFS from the entry block) are removed and every
+// remaining edge gets an increment such that summing the increments along any
+// entry-to-exit path yields a unique ID in [0, getNumPaths()). Paths are never
+// materialized: they are counted in O(V + E) and decoded on demand in
+// O(path length). The numbered set is the set of paths PathEnumerator produces
+// with maxLoopIterations = 0 on a reducible CFG.
+//
+// The numbering is over the nodes and edges of a CFGIndex, so it follows the
+// index's unique successors, superblocks and pruned cold edges as an
+// enumeration over the same index does. Decoded paths list every block of a
+// superblock.
+class PathNumbering {
+public:
+  explicit PathNumbering(std::shared_ptr<const CFGIndex> CFG);
+
+  // Number of acyclic entry-to-exit paths (saturates on overflow)
+  uint64_t getNumPaths() const;
+  bool hasOverflowed() const { return overflowed; }
+
+  // Rebuild the path with the given ID into 'path'. Returns false if the ID
+  // is out of range or the numbering has overflowed.
+  bool decode(uint64_t pathID, Path &path) const;
+
+  // Compute the ID of a path. Returns std::nullopt if the path does not start
+  // at the entry block, leaves the index (a pruned edge, or a superblock
+  // entered or left midway), uses a back edge or does not end at an exit
+  // block. Where several edges join the same two blocks the first one is
+  // used.
+  std::optional<uint64_t> encode(const Path &path) const;
+  // The same for a path of CFGIndex nodes, as PathView::getBlockIndices()
+  // returns them
+  std::optional<uint64_t> encode(llvm::ArrayRef<uint32_t> nodes) const;
+
+  // Edge increment of the successorIndex'th successor slot of BB's
+  // terminator (0 within a superblock), or std::nullopt for back edges,
+  // pruned edges and blocks of other functions.
+  std::optional<uint64_t> getIncrement(llvm::BasicBlock *BB,
+                                       unsigned successorIndex) const;
+
+  // Decode every path in ID order into a single reusable buffer. The callback
+  // receives (ID, path) and returns false to stop early.
+  template <typename Callback> void forEachPath(Callback &&callback) const {
+    Path path;
+    for (uint64_t id = 0, e = getNumPaths(); id < e; ++id) {
+      if (!decode(id, path))
+        return;
+      if (!callback(id, static_cast<const Path &>(path)))
+        return;
+    }
+  }
+
+private:
+  void findBackEdges();
+  void assignIncrements();
+  bool isExitBlock(unsigned block) const;
+  // First non-back edge from block to node target, or std::nullopt
+  std::optional<unsigned> findEdge(unsigned block, unsigned target) const;
+
+  std::shared_ptr<const CFGIndex> CFG;
+  std::vector<bool> isBackEdge;
+  // DFS post-order of the blocks reachable from the entry, i.e. reverse
+  // topological order of the acyclic CFG
+  std::vector<unsigned> postOrder;
+
+  std::vector<uint64_t> numPaths;
+  std::vector<uint64_t> increments;
+  bool overflowed;
+};
+
+} // namespace hepf
+
+#endif // PATH_NUMBERING_H
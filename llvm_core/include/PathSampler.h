@@ -0,0 +1,108 @@
+#ifndef PATH_SAMPLER_H
+#define PATH_SAMPLER_H
+
+#include "CFGIndex.h"
+#include "PathStore.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace llvm {
+class BranchProbabilityInfo;
+} // namespace llvm
+
+namespace hepf {
+
+// Monte Carlo path sampling for functions with too many paths to enumerate.
+//
+// Each sample is a random walk from the entry block to an exit block. At every
+// block the walk picks one of the successors it may still enter under the
+// loop iteration bound of PathStream, either with equal probability or in
+// proportion to BranchProbabilityInfo. Walks that get stuck (every successor
+// is over the bound) are discarded and redrawn. The generator is seeded
+// deterministically, so repeated runs give the same samples.
+class PathSampler {
+public:
+  static constexpr uint64_t DefaultSeed = 0x9e3779b97f4a7c15ULL;
+
+  // BPI = nullptr samples successors uniformly
+  PathSampler(std::shared_ptr<const CFGIndex> CFG, size_t maxLoopIterations,
+              const llvm::BranchProbabilityInfo *BPI = nullptr,
+              uint64_t seed = DefaultSeed);
+
+  // Draw the next path. Returns false if no complete walk was found within
+  // MaxAttempts tries, e.g. because the function has no reachable exit.
+  bool next();
+  PathView currentView() const { return PathView(*CFG, path); }
+
+  // Natural log of the probability that the walk draws the current path
+  double getLogProbability() const { return logProbability; }
+  bool isUniform() const { return edgeWeights.empty(); }
+  // Walks discarded because they got stuck
+  size_t getNumRejected() const { return numRejected; }
+
+private:
+  static constexpr unsigned MaxAttempts = 64;
+
+  bool walk();
+
+  std::shared_ptr<const CFGIndex> CFG;
+  size_t maxLoopIterations;
+  // Probability of every CFGIndex edge; empty for uniform sampling
+  std::vector<double> edgeWeights;
+  std::mt19937_64 rng;
+
+  std::vector<uint32_t> path;
+  std::vector<uint32_t> visitCount;
+  std::vector<uint32_t> candidates;
+  double logProbability;
+  size_t numRejected;
+};
+
+// Estimates the maximum and mean of a per-path metric from samples.
+//
+// Samples carry a log weight. With weight 0 (the default) the mean is the
+// plain sample mean, i.e. the mean under the sampling distribution. Passing
+// -getLogProbability() of a uniform walk instead weights each sample by the
+// inverse of its probability, so the self-normalized mean estimates the mean
+// over all paths, as exhaustive enumeration would report it.
+class SampleEstimator {
+public:
+  void add(double value, double logWeight = 0.0);
+
+  size_t getNumSamples() const { return samples.size(); }
+  // Largest sampled value: a lower bound of the true maximum
+  double getMax() const { return maxValue; }
+  double getMean() const;
+  // Half width of the normal-approximation confidence interval of the mean
+  // (z = 1.96 for 95%)
+  double getConfidenceHalfWidth(double z = 1.96) const;
+  // With 95% confidence, the paths whose value exceeds getMax() together
+  // have at most this probability under the sampling distribution
+  double getMissedMass() const;
+
+  // Print "max" and "mean" lines for the metric, e.g.
+  //   <indent>Maximum <metric>: >= 12<unit> (...)
+  //   <indent>Average <metric>: 8.4 +/- 0.1<unit> (95% CI)
+  void print(llvm::raw_ostream &OS, llvm::StringRef indent,
+             llvm::StringRef metric, llvm::StringRef unit = "") const;
+
+private:
+  struct Sample {
+    double value;
+    double logWeight;
+  };
+
+  // Weights relative to the largest one, so that they do not underflow
+  std::vector<double> getNormalizedWeights() const;
+
+  std::vector<Sample> samples;
+  double maxValue = 0.0;
+};
+
+} // namespace hepf
+
+#endif // PATH_SAMPLER_H
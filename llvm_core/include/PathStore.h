@@ -0,0 +1,192 @@
+#ifndef PATH_STORE_H
+#define PATH_STORE_H
+
+#include "CFGIndex.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace hepf {
+
+using Path = std::vector<llvm::BasicBlock *>;
+
+class PathStream;
+
+// Non-owning view of one path stored as CFGIndex block numbers. It iterates
+// and indexes like a Path (yielding BasicBlock pointers), so analyses written
+// against a view work on stored paths and on the live path of a PathStream.
+//
+// Over an index with superblocks the stored numbers are chain nodes; the view
+// still yields every basic block of the path, expanding the chains as it
+// goes. size() and operator[] then walk the path, which is fine for printing
+// but not for inner loops.
+class PathView {
+public:
+  class iterator
+      : public llvm::iterator_facade_base<iterator, std::forward_iterator_tag,
+                                          llvm::BasicBlock *, std::ptrdiff_t,
+                                          llvm::BasicBlock **,
+                                          llvm::BasicBlock *> {
+  public:
+    iterator() : CFG(nullptr), node(nullptr), pos(0) {}
+    iterator(const CFGIndex *CFG, const uint32_t *node)
+        : CFG(CFG), node(node), pos(0) {}
+
+    llvm::BasicBlock *operator*() const { return CFG->getChain(*node)[pos]; }
+    iterator &operator++() {
+      if (++pos == CFG->getChainLength(*node)) {
+        ++node;
+        pos = 0;
+      }
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return node == other.node && pos == other.pos;
+    }
+
+  private:
+    const CFGIndex *CFG;
+    const uint32_t *node;
+    unsigned pos;
+  };
+
+  PathView(const CFGIndex &CFG, llvm::ArrayRef<uint32_t> blocks)
+      : CFG(&CFG), blocks(blocks) {}
+
+  // Number of basic blocks
+  size_t size() const {
+    if (!CFG->hasSuperblocks())
+      return blocks.size();
+    size_t result = 0;
+    for (uint32_t node : blocks)
+      result += CFG->getChainLength(node);
+    return result;
+  }
+  bool empty() const { return blocks.empty(); }
+  llvm::BasicBlock *operator[](size_t i) const {
+    if (!CFG->hasSuperblocks())
+      return CFG->getBlock(blocks[i]);
+    return *std::next(begin(), i);
+  }
+  llvm::BasicBlock *front() const {
+    return CFG->getChain(blocks.front()).front();
+  }
+  llvm::BasicBlock *back() const {
+    return CFG->getChain(blocks.back()).back();
+  }
+
+  iterator begin() const { return iterator(CFG, blocks.begin()); }
+  iterator end() const { return iterator(CFG, blocks.end()); }
+
+  // CFGIndex block (or chain node) numbers of the path
+  llvm::ArrayRef<uint32_t> getBlockIndices() const { return blocks; }
+  const CFGIndex &getCFG() const { return *CFG; }
+
+  // Copy into an owning Path
+  Path toPath() const { return Path(begin(), end()); }
+
+private:
+  const CFGIndex *CFG;
+  llvm::ArrayRef<uint32_t> blocks;
+};
+
+// Compact storage for many paths of one function.
+//
+// All paths share one contiguous array of 32-bit CFGIndex block numbers; path
+// i occupies [offsets[i], offsets[i + 1]). Compared to one std::vector of
+// BasicBlock pointers per path this needs a single allocation, half the bytes
+// per block and keeps consecutive paths adjacent in memory.
+class PathStore {
+public:
+  explicit PathStore(std::shared_ptr<const CFGIndex> CFG);
+
+  size_t size() const { return offsets.size() - 1; }
+  bool empty() const { return size() == 0; }
+  PathView operator[](size_t i) const {
+    return PathView(*CFG, llvm::ArrayRef<uint32_t>(blocks).slice(
+                              offsets[i], offsets[i + 1] - offsets[i]));
+  }
+
+  // Iterates PathViews in insertion order
+  class iterator
+      : public llvm::iterator_facade_base<iterator,
+                                          std::random_access_iterator_tag,
+                                          PathView, std::ptrdiff_t, PathView *,
+                                          PathView> {
+  public:
+    iterator() : store(nullptr), index(0) {}
+    iterator(const PathStore *store, size_t index)
+        : store(store), index(index) {}
+
+    PathView operator*() const { return (*store)[index]; }
+    bool operator==(const iterator &other) const {
+      return index == other.index;
+    }
+    bool operator<(const iterator &other) const { return index < other.index; }
+    std::ptrdiff_t operator-(const iterator &other) const {
+      return index - other.index;
+    }
+    iterator &operator+=(std::ptrdiff_t n) {
+      index += n;
+      return *this;
+    }
+    iterator &operator-=(std::ptrdiff_t n) {
+      index -= n;
+      return *this;
+    }
+
+  private:
+    const PathStore *store;
+    size_t index;
+  };
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, size()); }
+
+  // Append one path given as CFGIndex block numbers
+  void append(llvm::ArrayRef<uint32_t> path);
+  // Append the first 'count' paths of another store over the same CFG
+  void append(const PathStore &other, size_t count);
+  // Drain a stream over the same CFG; returns the number of paths added
+  size_t append(PathStream &stream);
+
+  void reserve(size_t numPaths, size_t numBlocks);
+  void clear();
+  // Release unused capacity once no more paths will be added
+  void shrinkToFit();
+
+  // Total number of blocks over all paths
+  size_t getNumBlocks() const { return blocks.size(); }
+  const std::shared_ptr<const CFGIndex> &getCFG() const { return CFG; }
+  // Bytes held by the store itself
+  size_t getMemoryUsage() const;
+
+  // Binary form, all fields little-endian:
+  //   char[4]  magic "HPS1"
+  //   uint32   number of blocks in the CFG
+  //   uint64   number of paths N
+  //   uint64   number of stored blocks B
+  //   uint64   offsets[N + 1]
+  //   uint32   blocks[B]
+  void serialize(llvm::raw_ostream &OS) const;
+  // Read the binary form back. Returns std::nullopt if the data is malformed
+  // or was written for a CFG of a different size.
+  static std::optional<PathStore>
+  deserialize(llvm::StringRef data, std::shared_ptr<const CFGIndex> CFG);
+
+private:
+  std::shared_ptr<const CFGIndex> CFG;
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> blocks;
+};
+
+} // namespace hepf
+
+#endif // PATH_STORE_H
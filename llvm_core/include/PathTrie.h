@@ -0,0 +1,81 @@
+#ifndef PATH_TRIE_H
+#define PATH_TRIE_H
+
+#include "CFGIndex.h"
+#include "PathEnumerator.h"
+#include "llvm/ADT/ArrayRef.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hepf {
+
+// Shared-prefix storage for a depth-first path enumeration.
+//
+// Consecutive DFS paths share everything up to the branch point the DFS
+// backtracked to, so instead of copying each path the trie keeps one node per
+// block of the enumeration tree, with a parent index. Each complete path is
+// identified by its leaf node. Nodes are appended in DFS order, so a parent
+// always precedes its children and per-prefix results can be computed in one
+// forward sweep over the nodes and reused by every path below them.
+class PathTrie {
+public:
+  static constexpr uint32_t NoParent = UINT32_MAX;
+
+  struct Node {
+    uint32_t block;  // CFGIndex block number
+    uint32_t parent; // NoParent for the entry block
+  };
+
+  // Drain the stream into a trie
+  explicit PathTrie(PathStream &stream);
+  // Build the trie of stored paths, sharing the common prefix of consecutive
+  // paths. DFS order, as exhaustive enumeration produces it, shares every
+  // prefix; other orders (best-first) give a larger but equivalent trie.
+  explicit PathTrie(const PathStore &paths);
+
+  size_t getNumNodes() const { return nodes.size(); }
+  const Node &getNode(uint32_t node) const { return nodes[node]; }
+  llvm::BasicBlock *getBlock(uint32_t node) const {
+    return CFG->getBlock(nodes[node].block);
+  }
+  const CFGIndex &getCFG() const { return *CFG; }
+
+  // Leaf node of every path, in enumeration order
+  llvm::ArrayRef<uint32_t> getLeaves() const { return leaves; }
+  size_t getPathCount() const { return leaves.size(); }
+  bool hasReachedLimit() const { return reachedLimit; }
+
+  // Rebuild the path ending at the given leaf (or any node)
+  void getPath(uint32_t node, Path &path) const;
+
+  // Bytes held by the trie itself
+  size_t getMemoryUsage() const;
+
+  // Compute a value for every prefix of the enumeration tree:
+  //   value(root) = init(rootNode)
+  //   value(n)    = extend(value(parent(n)), n)
+  // Each prefix is evaluated exactly once, however many paths share it.
+  template <typename T, typename InitFn, typename ExtendFn>
+  std::vector<T> computePrefixValues(InitFn &&init, ExtendFn &&extend) const {
+    std::vector<T> values;
+    values.reserve(nodes.size());
+    for (uint32_t n = 0; n < nodes.size(); ++n) {
+      if (nodes[n].parent == NoParent)
+        values.push_back(init(n));
+      else
+        values.push_back(extend(values[nodes[n].parent], n));
+    }
+    return values;
+  }
+
+private:
+  std::shared_ptr<const CFGIndex> CFG;
+  std::vector<Node> nodes;
+  std::vector<uint32_t> leaves;
+  bool reachedLimit;
+};
+
+} // namespace hepf
+
+#endif // PATH_TRIE_H
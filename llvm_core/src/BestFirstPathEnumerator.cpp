@@ -0,0 +1,105 @@
+#include "BestFirstPathEnumerator.h"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <queue>
+
+using namespace llvm;
+using namespace hepf;
+
+BestFirstPathEnumerator::BestFirstPathEnumerator(
+    std::shared_ptr<const CFGIndex> CFG, const EnumerationBudget &budget,
+    std::vector<double> edgeProbabilities)
+    : CFG(std::move(CFG)), budget(budget),
+      edgeProbabilities(std::move(edgeProbabilities)),
+      limitHit(BudgetLimit::None), covered(0.0) {}
+
+double BestFirstPathEnumerator::getEdgeProbability(uint32_t block,
+                                                   unsigned edge) const {
+  if (edgeProbabilities.empty())
+    return 1.0 / (CFG->edgeEnd(block) - CFG->edgeBegin(block));
+  return edgeProbabilities[edge];
+}
+
+unsigned BestFirstPathEnumerator::countVisits(uint32_t node,
+                                              uint32_t block) const {
+  unsigned count = 0;
+  for (uint32_t n = node; n != NoParent; n = nodes[n].parent)
+    count += nodes[n].block == block;
+  return count;
+}
+
+PathStore BestFirstPathEnumerator::run() {
+  PathStore store(CFG);
+  nodes.clear();
+  covered = 0.0;
+  limitHit = BudgetLimit::None;
+  if (CFG->empty())
+    return store;
+
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (budget.timeMs)
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::milliseconds(budget.timeMs);
+  unsigned stepsUntilCheck = DeadlineCheckInterval;
+
+  std::priority_queue<Entry> queue;
+  std::vector<uint32_t> path;
+  nodes.push_back({0, NoParent});
+  queue.push({1.0, 0});
+
+  while (!queue.empty()) {
+    if (deadline && --stepsUntilCheck == 0) {
+      stepsUntilCheck = DeadlineCheckInterval;
+      if (std::chrono::steady_clock::now() >= *deadline) {
+        limitHit = BudgetLimit::Time;
+        break;
+      }
+    }
+    if (budget.memBytes &&
+        nodes.capacity() * sizeof(Node) + queue.size() * sizeof(Entry) +
+                store.getMemoryUsage() >
+            budget.memBytes) {
+      limitHit = BudgetLimit::Memory;
+      break;
+    }
+
+    Entry entry = queue.top();
+    uint32_t block = nodes[entry.node].block;
+
+    // Complete paths leave the queue in order of probability
+    if (CFG->isExit(block)) {
+      if (store.size() >= budget.maxPaths) {
+        limitHit = BudgetLimit::Paths;
+        break;
+      }
+      queue.pop();
+      path.clear();
+      for (uint32_t n = entry.node; n != NoParent; n = nodes[n].parent)
+        path.push_back(nodes[n].block);
+      std::reverse(path.begin(), path.end());
+      store.append(path);
+
+      covered += entry.probability;
+      if (covered >= budget.coverage && !queue.empty()) {
+        limitHit = BudgetLimit::Coverage;
+        break;
+      }
+      continue;
+    }
+
+    queue.pop();
+    for (unsigned edge = CFG->edgeBegin(block); edge < CFG->edgeEnd(block);
+         ++edge) {
+      uint32_t succ = CFG->getEdgeTarget(edge);
+      if (countVisits(entry.node, succ) > budget.maxLoopIterations)
+        continue;
+      nodes.push_back({succ, entry.node});
+      queue.push({entry.probability * getEdgeProbability(block, edge),
+                  uint32_t(nodes.size() - 1)});
+    }
+  }
+
+  store.shrinkToFit();
+  return store;
+}
@@ -0,0 +1,322 @@
+#include "CFGIndex.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace hepf;
+
+CFGIndex::CFGIndex(Function &F, bool uniqueSuccessors, bool superblocks,
+                   bool pruneCold)
+    : uniqueSuccessors(uniqueSuccessors) {
+  blocks.reserve(F.size());
+  for (BasicBlock &BB : F) {
+    blockIndex[&BB] = blocks.size();
+    blocks.push_back(&BB);
+  }
+
+  succOffsets.reserve(blocks.size() + 1);
+  succOffsets.push_back(0);
+  for (BasicBlock *BB : blocks) {
+    for (BasicBlock *Succ : llvm::successors(BB)) {
+      uint32_t target = blockIndex.lookup(Succ);
+      if (uniqueSuccessors) {
+        // Terminators have few distinct targets; a linear scan is enough
+        auto *begin = succs.data() + succOffsets.back();
+        auto *it = std::find(begin, succs.data() + succs.size(), target);
+        if (it != succs.data() + succs.size()) {
+          edgeMultiplicity[it - succs.data()]++;
+          continue;
+        }
+        edgeMultiplicity.push_back(1);
+      }
+      succs.push_back(target);
+    }
+    succOffsets.push_back(succs.size());
+  }
+
+  if (pruneCold && !blocks.empty())
+    pruneColdEdges();
+  if (superblocks && !blocks.empty())
+    contractChains();
+}
+
+// Blocks that end every path through them in an error or a rarely run call
+static bool isColdBlock(BasicBlock &BB) {
+  if (isa<UnreachableInst>(BB.getTerminator()))
+    return true;
+  for (Instruction &I : BB) {
+    if (auto *call = dyn_cast<CallBase>(&I)) {
+      if (call->doesNotReturn() || call->hasFnAttr(Attribute::Cold))
+        return true;
+    }
+  }
+  return false;
+}
+
+// Branch weights of a terminator's successor slots, if it has !prof weights
+static bool getBranchWeights(Instruction *TI,
+                             SmallVectorImpl<uint64_t> &weights) {
+  MDNode *MD = TI->getMetadata(LLVMContext::MD_prof);
+  if (!MD || MD->getNumOperands() != TI->getNumSuccessors() + 1)
+    return false;
+  auto *kind = dyn_cast<MDString>(MD->getOperand(0));
+  if (!kind || kind->getString() != "branch_weights")
+    return false;
+  weights.clear();
+  for (unsigned i = 1; i < MD->getNumOperands(); ++i) {
+    auto *weight = mdconst::dyn_extract<ConstantInt>(MD->getOperand(i));
+    if (!weight)
+      return false;
+    weights.push_back(weight->getZExtValue());
+  }
+  return true;
+}
+
+void CFGIndex::pruneColdEdges() {
+  const unsigned numBlocks = blocks.size();
+
+  // Blocks on a cycle, by strongly connected component, to spare loop exits
+  std::vector<uint32_t> scc(numBlocks, 0);
+  std::vector<uint8_t> cyclic;
+  Function *F = blocks[0]->getParent();
+  for (auto It = scc_begin(F); !It.isAtEnd(); ++It) {
+    for (BasicBlock *BB : *It)
+      scc[blockIndex.lookup(BB)] = cyclic.size();
+    cyclic.push_back(It.hasCycle());
+  }
+
+  std::vector<uint8_t> coldEdge(succs.size(), 0);
+  SmallVector<uint64_t, 8> weights;
+  for (unsigned block = 0; block < numBlocks; ++block) {
+    Instruction *TI = blocks[block]->getTerminator();
+    if (!getBranchWeights(TI, weights))
+      continue;
+    uint64_t total = 0;
+    for (uint64_t weight : weights)
+      total += weight;
+    for (unsigned edge = edgeBegin(block); edge < edgeEnd(block); ++edge) {
+      uint32_t target = succs[edge];
+      if (cyclic[scc[block]] && scc[block] != scc[target])
+        continue;
+      // A merged edge weighs as much as all of its slots
+      uint64_t weight = 0;
+      if (uniqueSuccessors) {
+        for (unsigned slot = 0; slot < TI->getNumSuccessors(); ++slot)
+          if (TI->getSuccessor(slot) == blocks[target])
+            weight += weights[slot];
+      } else {
+        weight = weights[edge - edgeBegin(block)];
+      }
+      coldEdge[edge] = weight < ColdEdgeThreshold * total;
+    }
+  }
+
+  // A block is kept if it reaches an exit that is not cold over edges and
+  // blocks that are not cold: a search backwards from those exits. Unlike
+  // propagating coldness forwards, this also prunes a loop whose every exit
+  // is cold, which no path leaves.
+  std::vector<uint8_t> cold(numBlocks, 0);
+  for (unsigned block = 0; block < numBlocks; ++block)
+    cold[block] = isColdBlock(*blocks[block]);
+  std::vector<uint32_t> predOffsets(numBlocks + 1, 0);
+  std::vector<uint32_t> predEdges(succs.size());
+  for (uint32_t target : succs)
+    predOffsets[target + 1]++;
+  for (unsigned block = 0; block < numBlocks; ++block)
+    predOffsets[block + 1] += predOffsets[block];
+  std::vector<uint32_t> fill(predOffsets.begin(), predOffsets.end() - 1);
+  std::vector<uint32_t> edgeSource(succs.size());
+  for (unsigned block = 0; block < numBlocks; ++block) {
+    for (unsigned edge = edgeBegin(block); edge < edgeEnd(block); ++edge) {
+      predEdges[fill[succs[edge]]++] = edge;
+      edgeSource[edge] = block;
+    }
+  }
+
+  std::vector<uint8_t> pruned(numBlocks, 1);
+  std::vector<uint32_t> worklist;
+  for (unsigned block = 0; block < numBlocks; ++block) {
+    if (isExit(block) && !cold[block]) {
+      pruned[block] = 0;
+      worklist.push_back(block);
+    }
+  }
+  while (!worklist.empty()) {
+    uint32_t block = worklist.back();
+    worklist.pop_back();
+    for (uint32_t i = predOffsets[block]; i < predOffsets[block + 1]; ++i) {
+      uint32_t edge = predEdges[i];
+      uint32_t pred = edgeSource[edge];
+      if (coldEdge[edge] || cold[pred] || !pruned[pred])
+        continue;
+      pruned[pred] = 0;
+      worklist.push_back(pred);
+    }
+  }
+  if (pruned[0])
+    return;
+  auto isPrunedEdge = [&](unsigned edge) {
+    return coldEdge[edge] || pruned[succs[edge]];
+  };
+
+  // Pruned blocks are no longer entered; only the edges of the others matter
+  std::vector<uint32_t> keptOffsets = {0};
+  std::vector<uint32_t> keptSuccs;
+  std::vector<uint32_t> keptMultiplicity;
+  for (unsigned block = 0; block < numBlocks; ++block) {
+    for (unsigned edge = edgeBegin(block); edge < edgeEnd(block); ++edge) {
+      if (!pruned[block] && isPrunedEdge(edge)) {
+        numPrunedEdges++;
+        continue;
+      }
+      keptSuccs.push_back(succs[edge]);
+      edgeSlots.push_back(edge - edgeBegin(block));
+      if (uniqueSuccessors)
+        keptMultiplicity.push_back(edgeMultiplicity[edge]);
+    }
+    keptOffsets.push_back(keptSuccs.size());
+  }
+  succOffsets = std::move(keptOffsets);
+  succs = std::move(keptSuccs);
+  edgeMultiplicity = std::move(keptMultiplicity);
+  if (numPrunedEdges == 0)
+    edgeSlots.clear();
+}
+
+void CFGIndex::contractChains() {
+  const unsigned numBlocks = blocks.size();
+
+  // A block continues the chain of its predecessor if it is the only
+  // successor slot of a block that is its only predecessor slot
+  std::vector<uint32_t> numPreds(numBlocks, 0);
+  std::vector<uint32_t> pred(numBlocks, 0);
+  for (unsigned block = 0; block < numBlocks; ++block) {
+    for (unsigned edge = edgeBegin(block); edge < edgeEnd(block); ++edge) {
+      numPreds[succs[edge]] += getEdgeMultiplicity(edge);
+      pred[succs[edge]] = block;
+    }
+  }
+  auto continuesChain = [&](uint32_t block) {
+    uint32_t p = pred[block];
+    return block != 0 && numPreds[block] == 1 && p != block &&
+           edgeEnd(p) - edgeBegin(p) == 1 &&
+           getEdgeMultiplicity(edgeBegin(p)) == 1;
+  };
+
+  // Chains start at every other block. Blocks on a cycle of continuations
+  // are unreachable and start chains in a second round.
+  std::vector<uint32_t> node(numBlocks, UINT32_MAX);
+  std::vector<uint32_t> heads, tails;
+  chainOffsets.push_back(0);
+  auto buildChain = [&](uint32_t block) {
+    heads.push_back(block);
+    while (true) {
+      node[block] = tails.size();
+      chainBlocks.push_back(blocks[block]);
+      if (edgeEnd(block) - edgeBegin(block) != 1)
+        break;
+      uint32_t next = succs[edgeBegin(block)];
+      if (node[next] != UINT32_MAX || !continuesChain(next))
+        break;
+      block = next;
+    }
+    tails.push_back(block);
+    chainOffsets.push_back(chainBlocks.size());
+  };
+  for (uint32_t block = 0; block < numBlocks; ++block)
+    if (!continuesChain(block))
+      buildChain(block);
+  for (uint32_t block = 0; block < numBlocks; ++block)
+    if (node[block] == UINT32_MAX)
+      buildChain(block);
+
+  // Successors of a node are those of the last block of its chain
+  std::vector<BasicBlock *> nodeBlocks;
+  std::vector<uint32_t> nodeOffsets = {0};
+  std::vector<uint32_t> nodeSuccs;
+  std::vector<uint32_t> nodeMultiplicity;
+  std::vector<uint32_t> nodeSlots;
+  for (unsigned n = 0; n < heads.size(); ++n) {
+    nodeBlocks.push_back(blocks[heads[n]]);
+    for (unsigned edge = edgeBegin(tails[n]); edge < edgeEnd(tails[n]);
+         ++edge) {
+      nodeSuccs.push_back(node[succs[edge]]);
+      if (uniqueSuccessors)
+        nodeMultiplicity.push_back(edgeMultiplicity[edge]);
+      if (!edgeSlots.empty())
+        nodeSlots.push_back(edgeSlots[edge]);
+    }
+    nodeOffsets.push_back(nodeSuccs.size());
+  }
+
+  for (uint32_t block = 0; block < numBlocks; ++block)
+    blockIndex[blocks[block]] = node[block];
+  blocks = std::move(nodeBlocks);
+  succOffsets = std::move(nodeOffsets);
+  succs = std::move(nodeSuccs);
+  edgeMultiplicity = std::move(nodeMultiplicity);
+  edgeSlots = std::move(nodeSlots);
+}
+
+uint64_t CFGIndex::getPathMultiplicity(ArrayRef<uint32_t> path) const {
+  if (!uniqueSuccessors)
+    return 1;
+
+  uint64_t result = 1;
+  for (size_t i = 0; i + 1 < path.size(); ++i) {
+    ArrayRef<uint32_t> succ = successors(path[i]);
+    unsigned edge = edgeBegin(path[i]) + (llvm::find(succ, path[i + 1]) -
+                                          succ.begin());
+    if (__builtin_mul_overflow(result, edgeMultiplicity[edge], &result))
+      return UINT64_MAX;
+  }
+  return result;
+}
+
+std::vector<double>
+CFGIndex::getEdgeProbabilities(const BranchProbabilityInfo &BPI) const {
+  std::vector<double> result(succs.size());
+  for (unsigned block = 0; block < size(); ++block) {
+    BasicBlock *BB = getChain(block).back();
+    for (unsigned edge = edgeBegin(block); edge < edgeEnd(block); ++edge) {
+      BranchProbability BP =
+          uniqueSuccessors
+              ? BPI.getEdgeProbability(BB, getBlock(getEdgeTarget(edge)))
+              : BPI.getEdgeProbability(BB, getEdgeSlot(block, edge));
+      result[edge] =
+          BP.isUnknown()
+              ? 0.0
+              : static_cast<double>(BP.getNumerator()) / BP.getDenominator();
+    }
+  }
+  return result;
+}
+
+std::vector<uint32_t> CFGIndex::getReversePostOrder() const {
+  std::vector<uint32_t> order;
+  if (empty())
+    return order;
+  std::vector<uint8_t> visited(size(), 0);
+  std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, edgeBegin(0)}};
+  visited[0] = 1;
+  while (!stack.empty()) {
+    auto &[block, edge] = stack.back();
+    if (edge == edgeEnd(block)) {
+      order.push_back(block);
+      stack.pop_back();
+      continue;
+    }
+    uint32_t succ = getEdgeTarget(edge++);
+    if (!visited[succ]) {
+      visited[succ] = 1;
+      stack.emplace_back(succ, edgeBegin(succ));
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
@@ -0,0 +1,21 @@
+#include "ChainSummary.h"
+
+using namespace llvm;
+using namespace hepf;
+
+std::vector<ChainSummary>
+hepf::summarizeChains(const CFGIndex &CFG,
+                      function_ref<int(BasicBlock *)> getLockDelta) {
+  std::vector<ChainSummary> summaries(CFG.size());
+  for (unsigned node = 0; node < CFG.size(); ++node) {
+    ChainSummary &summary = summaries[node];
+    for (BasicBlock *BB : CFG.getChain(node)) {
+      summary.numInstructions += BB->size();
+      summary.lockDelta += getLockDelta(BB);
+      for (Instruction &I : *BB)
+        if (auto *call = dyn_cast<CallBase>(&I))
+          summary.calls.push_back(call);
+    }
+  }
+  return summaries;
+}
@@ -0,0 +1,118 @@
+#include "EnumerationBudget.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/Format.h"
+#include <climits>
+
+using namespace llvm;
+using namespace hepf;
+
+std::optional<EnumerationBudget>
+EnumerationBudget::parse(StringRef params) const {
+  EnumerationBudget result = *this;
+
+  SmallVector<StringRef, 4> pairs;
+  params.split(pairs, ';', -1, /*KeepEmpty=*/false);
+  for (StringRef pair : pairs) {
+    auto [key, value] = pair.split('=');
+
+    // Flags are given bare or as =0/=1
+    bool *flag = StringSwitch<bool *>(key)
+                     .Case("unique-successors", &result.uniqueSuccessors)
+                     .Case("superblocks", &result.superblocks)
+                     .Case("prune-cold", &result.pruneCold)
+                     .Default(nullptr);
+    if (flag && key.size() == pair.size()) {
+      *flag = true;
+      continue;
+    }
+
+    if (key == "coverage") {
+      double fraction;
+      if (value.getAsDouble(fraction) || !(fraction > 0.0 && fraction <= 1.0))
+        return std::nullopt;
+      result.coverage = fraction;
+      continue;
+    }
+
+    uint64_t number;
+    if (value.getAsInteger(10, number))
+      return std::nullopt;
+
+    if (key == "max-paths") {
+      result.maxPaths = number;
+    } else if (key == "max-loop-iterations") {
+      result.maxLoopIterations = number;
+    } else if (key == "time-ms") {
+      result.timeMs = number;
+    } else if (key == "threads") {
+      if (number > UINT_MAX)
+        return std::nullopt;
+      result.numThreads = number;
+    } else if (flag && number <= 1) {
+      *flag = number;
+    } else if (key == "mem-mb") {
+      if (number > UINT64_MAX >> 20)
+        return std::nullopt;
+      result.memBytes = number << 20;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return result;
+}
+
+void EnumerationBudget::print(raw_ostream &OS, BudgetLimit limit) const {
+  switch (limit) {
+  case BudgetLimit::None:
+    break;
+  case BudgetLimit::Paths:
+    OS << "max-paths=" << maxPaths;
+    break;
+  case BudgetLimit::Time:
+    OS << "time-ms=" << timeMs;
+    break;
+  case BudgetLimit::Memory:
+    OS << "mem-mb=" << (memBytes >> 20);
+    break;
+  case BudgetLimit::Coverage:
+    OS << "coverage=" << format("%g", coverage);
+    break;
+  }
+}
+
+void EnumerationBudget::printLimitReached(raw_ostream &OS,
+                                          BudgetLimit limit) const {
+  OS << getBudgetLimitName(limit) << " reached (";
+  print(OS, limit);
+  OS << ")";
+}
+
+StringRef hepf::getBudgetLimitName(BudgetLimit limit) {
+  switch (limit) {
+  case BudgetLimit::None:
+    return "No limit";
+  case BudgetLimit::Paths:
+    return "Path limit";
+  case BudgetLimit::Time:
+    return "Time budget";
+  case BudgetLimit::Memory:
+    return "Memory budget";
+  case BudgetLimit::Coverage:
+    return "Coverage target";
+  }
+  return "";
+}
+
+bool hepf::matchPassName(StringRef name, StringRef passName,
+                         StringRef &params) {
+  params = "";
+  if (!name.consume_front(passName))
+    return false;
+  if (name.empty())
+    return true;
+  if (!name.consume_front("<") || !name.consume_back(">"))
+    return false;
+  params = name;
+  return true;
+}
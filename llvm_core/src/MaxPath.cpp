@@ -1,15 +1,22 @@
 #include "MaxPath.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSwitch.h"
 #include <unordered_map>
-#include <unordered_set>
 #include <memory>
+#include <vector>
 #include <algorithm>
 #include <iterator>
 
@@ -21,86 +28,323 @@ namespace {
 // Helper Functions
 // -----------------------------------------------------------
 
-// Helper function to recursively compute the longest path from a given instruction
-int computeLongestPath(Instruction *I,
-                       std::unordered_map<Instruction *, int> &memo,
-                       std::unordered_set<Instruction *> &visiting,
-                       DependenceInfo &DI) {
-
-    // 1. Cycle Detection (Crucial for handling loops and recurrences)
-    if (visiting.count(I)) {
-        return 0; // Cut the back-edge.
-    }
-
-    // 2. Memoization
-    if (memo.count(I)) {
-        return memo[I];
+// Memory dependence successors of every memory instruction
+using MemorySuccessors =
+    std::unordered_map<Instruction *, std::vector<Instruction *>>;
+
+// MemorySSA accesses visited per chain walk before the next definition is
+// taken as a (conservative) dependence, as MemorySSA's own walker bounds its
+// clobber queries
+static constexpr unsigned MaxChainSteps = 100;
+
+// Dependences collected per branch of a chain walk; the walk ends the branch
+// there, so each further definition costs at most this many alias queries
+static constexpr unsigned MaxDependencesPerBranch = 4;
+
+// Whether two memory instructions may touch the same memory with at least one
+// of them writing it; instructions without a single location (calls) are
+// compared by the location of the other, or assumed to conflict
+static bool mayConflict(AAResults &AA, Instruction *A, Instruction *B) {
+    Optional<MemoryLocation> Loc = MemoryLocation::getOrNone(B);
+    if (!Loc) {
+        std::swap(A, B);
+        Loc = MemoryLocation::getOrNone(B);
+        if (!Loc)
+            return true;
     }
+    ModRefInfo MR = AA.getModRefInfo(A, *Loc);
+    return isModSet(MR) || (B->mayWriteToMemory() && isRefSet(MR));
+}
 
-    visiting.insert(I);
-    int maxLength = 0;
-
-    // A. Iterate over uses (Data Dependence / Use-Def Chain)
-    // This handles all value flow dependencies (X = Y + Z; User = X).
-    for (auto &use : I->uses()) {
-        if (Instruction *user = dyn_cast<Instruction>(use.getUser())) {
-            // Data dependence always constitutes a valid path edge.
-            maxLength = std::max(maxLength,
-                                 computeLongestPath(user, memo, visiting, DI));
+// Build the memory dependence edges from MemorySSA instead of querying
+// DependenceInfo for every pair of memory instructions. From every access,
+// the chain of definitions is walked through MemoryPhis
+//   - upwards to the definitions that may conflict with it (read after
+//     write, write after write), and
+//   - for a read, downwards to the later definitions that may overwrite what
+//     it reads (write after read).
+// A walk does not stop at the first dependence: a farther definition can
+// conflict with the access without conflicting with the nearer one, e.g. a
+// store to p above a store to a noalias q, both above a call. Only a
+// definition that itself depends on one already found on the same branch
+// gets no edge of its own, since it reaches the access through that one,
+// with a path at least as long. A branch ends after MaxDependencesPerBranch
+// dependences. Unlike the full scan, instructions on
+// exclusive paths (e.g. both arms of a diamond) are not chained. An edge to
+// an instruction that is not after its source in the function layout is
+// loop-carried; the full scan has none, so these are dropped. Given DI,
+// every other edge is confirmed with the full scan's DependenceInfo query,
+// so the edges are a subset of its edges.
+MemorySuccessors buildMemorySSAEdges(Function &F, MemorySSA &MSSA,
+                                     AAResults &AA, DependenceInfo *DI) {
+    MemorySuccessors successors;
+
+    // Layout position of every instruction
+    std::unordered_map<Instruction *, unsigned> position;
+    for (Instruction &I : instructions(F))
+        position[&I] = position.size();
+
+    // Whether From -> To is a dependence of this tier. Like the full scan,
+    // only from earlier to later in layout order: a loop-carried edge would
+    // close a cycle that the full scan never has.
+    auto depends = [&](Instruction *From, Instruction *To, bool checkAlias) {
+        if (position[To] <= position[From])
+            return false;
+        if (checkAlias && !mayConflict(AA, From, To))
+            return false;
+        return !DI || DI->depends(From, To, true) != nullptr;
+    };
+    auto addEdge = [&](Instruction *From, Instruction *To) {
+        // Data-flow uses are already edges of the use-def chain
+        if (!llvm::is_contained(To->operands(), From))
+            successors[From].push_back(To);
+    };
+
+    // Walk the definitions from Start, upwards (defining accesses, incoming
+    // values of phis) or downwards (users), and add the edges between I and
+    // the definitions it depends on. Each access carries the definitions
+    // found on every branch that reaches it.
+    auto walk = [&](Instruction *I, MemoryAccess *Start, bool upwards) {
+        using Found = SmallVector<Instruction *, 4>;
+        SmallVector<MemoryAccess *, 8> worklist = {Start};
+        DenseMap<MemoryAccess *, Found> foundAt = {{Start, {}}};
+        unsigned steps = 0;
+        auto push = [&](MemoryAccess *Next, const Found &found) {
+            if (isa<MemoryUse>(Next))
+                return;
+            auto [It, inserted] = foundAt.try_emplace(Next, found);
+            if (!inserted) {
+                // Reached again: only what every branch found still covers
+                size_t before = It->second.size();
+                llvm::erase_if(It->second, [&](Instruction *Def) {
+                    return !llvm::is_contained(found, Def);
+                });
+                if (It->second.size() == before)
+                    return;
+            }
+            worklist.push_back(Next);
+        };
+        auto pushNext = [&](MemoryAccess *Current, const Found &found) {
+            if (!upwards) {
+                for (User *U : Current->users())
+                    if (auto *Next = dyn_cast<MemoryAccess>(U))
+                        push(Next, found);
+            } else if (auto *Phi = dyn_cast<MemoryPhi>(Current)) {
+                for (Value *Incoming : Phi->incoming_values())
+                    push(cast<MemoryAccess>(Incoming), found);
+            } else {
+                push(cast<MemoryDef>(Current)->getDefiningAccess(), found);
+            }
+        };
+        while (!worklist.empty()) {
+            MemoryAccess *Current = worklist.pop_back_val();
+            Found found = foundAt[Current];
+            // Downwards, the walk starts from the definition before I
+            auto *Def = dyn_cast<MemoryDef>(Current);
+            if (!Def || (!upwards && Current == Start)) {
+                pushNext(Current, found);
+                continue;
+            }
+            if (MSSA.isLiveOnEntryDef(Def))
+                continue;
+            Instruction *Other = Def->getMemoryInst();
+            Instruction *From = upwards ? Other : I;
+            Instruction *To = upwards ? I : Other;
+            if (Other != I) {
+                // Past the step bound, take the definition as a
+                // (conservative) dependence and end the branch
+                if (++steps > MaxChainSteps) {
+                    if (depends(From, To, /*checkAlias=*/false))
+                        addEdge(From, To);
+                    continue;
+                }
+                if (depends(From, To, /*checkAlias=*/true)) {
+                    bool covered = llvm::any_of(found, [&](Instruction *Near) {
+                        return upwards ? depends(Other, Near, true)
+                                       : depends(Near, Other, true);
+                    });
+                    if (!covered)
+                        addEdge(From, To);
+                    found.push_back(Other);
+                    if (found.size() == MaxDependencesPerBranch)
+                        continue;
+                }
+            }
+            pushNext(Current, found);
         }
-    }
+    };
 
-    // B. Check for Memory Dependencies
-        if (I->mayReadOrWriteMemory()) {
-
-            // --- 1. Iterate through the rest of the current BasicBlock ---
-            // Get the iterator pointing to the instruction immediately following I
-            BasicBlock::iterator nextInst = I->getIterator();
-            ++nextInst;
+    for (Instruction &I : instructions(F)) {
+        MemoryUseOrDef *Access = MSSA.getMemoryAccess(&I);
+        if (!Access)
+            continue;
+        walk(&I, Access->getDefiningAccess(), /*upwards=*/true);
+        if (isa<MemoryUse>(Access))
+            walk(&I, Access->getDefiningAccess(), /*upwards=*/false);
+    }
+    return successors;
+}
 
-            for (; nextInst != I->getParent()->end(); ++nextInst) {
-                Instruction *user = &*nextInst;
+// Dependence graph of a function's instructions in CSR form: node i is the
+// i-th instruction in layout order and its edges are
+// [offsets[i], offsets[i + 1]). A use edge has weight 0 and a memory
+// dependence edge weight 1; every instruction counts 1 itself.
+struct DependenceGraph {
+    std::vector<Instruction *> nodes;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<uint8_t> weights;
+};
+
+// Memory dependences of I by the full scan: a DependenceInfo query against
+// every later memory instruction in the function layout that does not use I
+// as an operand (that is a data-flow edge already)
+template <typename Callback>
+void scanMemoryDependences(Instruction *I, DependenceInfo &DI, Callback found) {
+    if (!I->mayReadOrWriteMemory())
+        return;
+    auto check = [&](Instruction *user) {
+        if (user->mayReadOrWriteMemory() && !llvm::is_contained(user->operands(), I) &&
+            DI.depends(I, user, true))
+            found(user);
+    };
+
+    // --- 1. The rest of the current BasicBlock ---
+    for (auto It = std::next(I->getIterator()), E = I->getParent()->end(); It != E; ++It)
+        check(&*It);
+
+    // --- 2. All subsequent BasicBlocks in the Function ---
+    Function *F = I->getFunction();
+    for (auto BBI = std::next(I->getParent()->getIterator()), E = F->end(); BBI != E; ++BBI)
+        for (Instruction &user : *BBI)
+            check(&user);
+}
 
-                // Check if the potential dependent accesses memory and is not a simple data-flow use
-                if (user->mayReadOrWriteMemory() && !llvm::is_contained(user->operands(), I)) {
+// Materialize the use-def and memory dependence edges of F; the memory
+// dependences of I are reported by forEachMemoryDependence(I, found)
+template <typename MemoryDependences>
+DependenceGraph buildDependenceGraph(Function &F,
+                                     MemoryDependences forEachMemoryDependence) {
+    DependenceGraph G;
+    DenseMap<const Instruction *, uint32_t> index;
+    for (Instruction &I : instructions(F)) {
+        index[&I] = G.nodes.size();
+        G.nodes.push_back(&I);
+    }
+    G.offsets.reserve(G.nodes.size() + 1);
+
+    auto addEdge = [&](Instruction *To, uint8_t weight) {
+        G.targets.push_back(index.lookup(To));
+        G.weights.push_back(weight);
+    };
+    auto addMemoryEdge = [&](Instruction *To) { addEdge(To, 1); };
+    for (Instruction *I : G.nodes) {
+        G.offsets.push_back(G.targets.size());
+
+        // A. Data dependence (use-def chain)
+        for (User *U : I->users())
+            if (auto *user = dyn_cast<Instruction>(U))
+                addEdge(user, 0);
+
+        // B. Memory dependences
+        forEachMemoryDependence(I, addMemoryEdge);
+    }
+    G.offsets.push_back(G.targets.size());
+    return G;
+}
 
-                    std::unique_ptr<llvm::Dependence> Dep = DI.depends(I, user, true);
-                    if (Dep) {
-                        // Update maxLength with the longest path found through this memory dependence edge
-                        maxLength = std::max(maxLength,
-                                             1 + computeLongestPath(user, memo, visiting, DI));
-                    }
+// Longest path over the dependence graph, counting instructions and memory
+// edges. The graph is condensed into its strongly connected components
+// (recurrences through loop-carried PHIs or memory). A component counts
+// each of its instructions once plus its internal memory edges, at most one
+// between each two instructions: a bound on any simple path through it, so
+// an edge that closes a cycle never makes a path shorter. Tarjan's
+// algorithm, run iteratively, emits the components in reverse topological
+// order, so every component's longest path is final when a component that
+// reaches it is emitted. The result does not depend on visit order and the
+// depth of the graph is not limited by the call stack.
+//
+// With saturate set, every component with two or more memory instructions
+// counts the cap of size - 1 memory edges whatever edges it holds. A graph
+// with fewer memory edges inside a recurrence than the full scan (such as
+// the next-memory chain) then still bounds the full scan's longest path.
+int longestDependencePath(const DependenceGraph &G, bool saturate = false) {
+    constexpr uint32_t None = UINT32_MAX;
+    const uint32_t numNodes = G.nodes.size();
+
+    std::vector<uint32_t> order(numNodes, None);     // DFS discovery index
+    std::vector<uint32_t> lowLink(numNodes);
+    std::vector<uint32_t> component(numNodes, None);
+    std::vector<int> componentPath;                  // longest path from a component
+    std::vector<uint32_t> sccStack;                  // nodes of open components
+    std::vector<std::pair<uint32_t, uint32_t>> dfs;  // node, next edge
+    uint32_t nextOrder = 0;
+    int maxPath = 0;
+
+    for (uint32_t root = 0; root < numNodes; ++root) {
+        if (order[root] != None)
+            continue;
+        order[root] = lowLink[root] = nextOrder++;
+        sccStack.push_back(root);
+        dfs.push_back({root, G.offsets[root]});
+
+        while (!dfs.empty()) {
+            auto &[node, edge] = dfs.back();
+            if (edge < G.offsets[node + 1]) {
+                uint32_t succ = G.targets[edge++];
+                if (order[succ] == None) {
+                    order[succ] = lowLink[succ] = nextOrder++;
+                    sccStack.push_back(succ);
+                    dfs.push_back({succ, G.offsets[succ]});
+                } else if (component[succ] == None) {
+                    // Still open, so on the SCC stack
+                    lowLink[node] = std::min(lowLink[node], order[succ]);
                 }
+                continue;
             }
 
-            // --- 2. Iterate through all subsequent BasicBlocks in the Function ---
-            Function *F = I->getFunction();
-            // Start from the basic block immediately following I's parent block
-            auto BB_start = std::next(I->getParent()->getIterator());
-
-            for (auto BBI = BB_start, E = F->end(); BBI != E; ++BBI) {
-                for (Instruction &user : *BBI) {
-
-                    // Check if the potential dependent accesses memory and is not a simple data-flow use
-                    if (user.mayReadOrWriteMemory() && !llvm::is_contained(user.operands(), I)) {
-
-                        std::unique_ptr<llvm::Dependence> Dep = DI.depends(I, &user, true);
-                        if (Dep) {
-                            maxLength = std::max(maxLength,
-                                                 1 + computeLongestPath(&user, memo, visiting, DI));
-                        }
-                    }
+            uint32_t done = node;
+            dfs.pop_back();
+            if (!dfs.empty())
+                lowLink[dfs.back().first] =
+                    std::min(lowLink[dfs.back().first], lowLink[done]);
+            if (lowLink[done] != order[done])
+                continue;
+
+            // done is the root of a component: its nodes are on top of the
+            // SCC stack, and every component they reach is already closed
+            const uint32_t id = componentPath.size();
+            size_t first = sccStack.size();
+            do {
+                component[sccStack[--first]] = id;
+            } while (sccStack[first] != done);
+
+            int longestSuccessor = 0;
+            int internalWeight = 0;
+            int memoryInstructions = 0;
+            for (size_t i = first; i < sccStack.size(); ++i) {
+                uint32_t member = sccStack[i];
+                if (G.nodes[member]->mayReadOrWriteMemory())
+                    memoryInstructions++;
+                for (uint32_t e = G.offsets[member]; e < G.offsets[member + 1]; ++e) {
+                    uint32_t target = component[G.targets[e]];
+                    if (target == id)
+                        internalWeight += G.weights[e];
+                    else
+                        longestSuccessor = std::max(longestSuccessor,
+                                                    G.weights[e] + componentPath[target]);
                 }
             }
+            int size = int(sccStack.size() - first);
+            if (saturate && memoryInstructions >= 2)
+                internalWeight = size - 1;
+            int pathLength = size + std::min(size - 1, internalWeight) + longestSuccessor;
+            componentPath.push_back(pathLength);
+            maxPath = std::max(maxPath, pathLength);
+            sccStack.resize(first);
         }
-
-    // --- Backtrack and Store ---
-    visiting.erase(I);
-
-    // The path length is 1 (for I itself) + the longest path from its successors
-    int pathLength = 1 + maxLength;
-    memo[I] = pathLength;
-    return pathLength;
+    }
+    return maxPath;
 }
 
 } // namespace
@@ -111,6 +355,44 @@ int computeLongestPath(Instruction *I,
 
 // --- MaxPathPass Implementation ---
 
+std::optional<MaxPathPass::Options>
+MaxPathPass::Options::parse(StringRef Params) const {
+    Options result = *this;
+    bool hasThreshold = false;
+
+    SmallVector<StringRef, 2> items;
+    Params.split(items, ';', -1, /*KeepEmpty=*/false);
+    for (StringRef item : items) {
+        auto [key, value] = item.split('=');
+        if (key == "threshold") {
+            if (value.getAsInteger(10, result.threshold))
+                return std::nullopt;
+            hasThreshold = true;
+            continue;
+        }
+        std::optional<Precision> precision =
+            StringSwitch<std::optional<Precision>>(item)
+                .Case("usedef", Precision::UseDef)
+                .Case("aa", Precision::AliasAnalysis)
+                .Case("memoryssa", Precision::MemorySSA)
+                .Case("full", Precision::DependenceInfo)
+                .Case("auto", Precision::Auto)
+                .Default(std::nullopt);
+        if (!precision)
+            return std::nullopt;
+        result.precision = *precision;
+    }
+
+    // Only Auto reports against a threshold, and it needs one: below a
+    // threshold of 0 nothing is skipped, so Auto would compute both bounds
+    // and then run the full scan anyway
+    if (hasThreshold && result.precision != Precision::Auto)
+        return std::nullopt;
+    if (result.precision == Precision::Auto && result.threshold == 0)
+        return std::nullopt;
+    return result;
+}
+
 PreservedAnalyses MaxPathPass::run(Module &M, ModuleAnalysisManager &AM) {
     errs() << "=== MaxPath Analysis ===\n\n";
 
@@ -127,31 +409,89 @@ PreservedAnalyses MaxPathPass::run(Module &M, ModuleAnalysisManager &AM) {
         if (F.isDeclaration())
             continue;
 
-        // Get the DependenceInfo for the function
-        DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
-
-        std::unordered_map<Instruction *, int> memo;
-        int maxPath = 0;
         int BasicBlockCount = 0;
         int InstructionCount = 0;
-
         for (BasicBlock &BB : F) {
             totalBasicBlock++;
             BasicBlockCount++;
+            totalInstructions += BB.size();
+            InstructionCount += BB.size();
+        }
 
-            for (Instruction &I : BB) {
-                totalInstructions++;
-                InstructionCount++;
-
-                // The visiting set is local to the current DFS call stack
-                std::unordered_set<Instruction *> visiting;
-
-                maxPath = std::max(maxPath, computeLongestPath(&I, memo, visiting, DI));
+        int maxPath = 0;
+        // Set when Auto stops at the use-def lower bound below the threshold
+        std::optional<int> upperBound;
+        switch (Opts.precision) {
+        case Precision::UseDef:
+            maxPath = longestDependencePath(
+                buildDependenceGraph(F, [](Instruction *, auto &&) {}));
+            break;
+        case Precision::AliasAnalysis:
+        case Precision::MemorySSA: {
+            DependenceInfo *DI = Opts.precision == Precision::MemorySSA
+                                     ? &FAM.getResult<DependenceAnalysis>(F)
+                                     : nullptr;
+            MemorySuccessors memoryEdges = buildMemorySSAEdges(
+                F, FAM.getResult<MemorySSAAnalysis>(F).getMSSA(),
+                FAM.getResult<AAManager>(F), DI);
+            maxPath = longestDependencePath(buildDependenceGraph(
+                F, [&](Instruction *I, auto &&found) {
+                    auto It = memoryEdges.find(I);
+                    if (It != memoryEdges.end())
+                        for (Instruction *user : It->second)
+                            found(user);
+                }));
+            break;
+        }
+        case Precision::Auto: {
+            // Bounds of the full scan in linear time: without memory edges,
+            // and with every memory instruction depending on the next one in
+            // layout order, which reaches each later one on a longer path.
+            // Inside a recurrence the chain has fewer memory edges than the
+            // full scan, so its components count the capped weight.
+            int lowerBound = longestDependencePath(
+                buildDependenceGraph(F, [](Instruction *, auto &&) {}));
+            DenseMap<Instruction *, Instruction *> nextMemory;
+            Instruction *next = nullptr;
+            for (BasicBlock &BB : llvm::reverse(F)) {
+                for (Instruction &I : llvm::reverse(BB)) {
+                    if (!I.mayReadOrWriteMemory())
+                        continue;
+                    if (next)
+                        nextMemory[&I] = next;
+                    next = &I;
+                }
+            }
+            int chainBound = longestDependencePath(buildDependenceGraph(
+                F, [&](Instruction *I, auto &&found) {
+                    if (Instruction *user = nextMemory.lookup(I))
+                        found(user);
+                }),
+                /*saturate=*/true);
+            if (lowerBound == chainBound || chainBound < int(Opts.threshold)) {
+                maxPath = lowerBound;
+                if (lowerBound != chainBound)
+                    upperBound = chainBound;
+                break;
             }
+            [[fallthrough]];
+        }
+        case Precision::DependenceInfo: {
+            DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+            maxPath = longestDependencePath(buildDependenceGraph(
+                F, [&](Instruction *I, auto &&found) {
+                    scanMemoryDependences(I, DI, found);
+                }));
+            break;
+        }
         }
 
         // Print the result expected by the test harness
-        errs() << "Function: " << F.getName() << ", Basic Blocks: " << BasicBlockCount << ", Instructions: " << InstructionCount << ", MaxPath: " << maxPath << "\n";
+        errs() << "Function: " << F.getName() << ", Basic Blocks: " << BasicBlockCount << ", Instructions: " << InstructionCount << ", MaxPath: " << maxPath;
+        if (upperBound)
+            errs() << " (use-def lower bound; at most " << *upperBound
+                   << ", below threshold " << Opts.threshold << ")";
+        errs() << "\n";
         errs().flush();
 
         // Add a metadata node to the function to mark it as modified
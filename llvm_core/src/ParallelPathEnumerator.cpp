@@ -0,0 +1,276 @@
+#include "ParallelPathEnumerator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Threading.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace llvm;
+using namespace hepf;
+
+namespace {
+
+// Tasks per thread created by the initial split; more tasks balance better,
+// fewer tasks waste less on prefixes
+constexpr size_t TasksPerThread = 16;
+// Maximum number of branch levels the split descends
+constexpr unsigned MaxSplitRounds = 32;
+
+// -----------------------------------------------------------
+// Work-stealing pool
+// -----------------------------------------------------------
+// Each worker owns a deque of task indices. It takes work from the front of
+// its own deque (lowest index first, so earlier tasks finish early) and, when
+// that is empty, steals from the back of another worker's deque.
+class WorkStealingPool {
+public:
+  WorkStealingPool(unsigned numWorkers, size_t numTasks)
+      : workers(numWorkers) {
+    for (auto &W : workers)
+      W = std::make_unique<Worker>();
+    for (size_t task = 0; task < numTasks; ++task)
+      workers[task % numWorkers]->tasks.push_back(task);
+  }
+
+  template <typename Body> void run(Body &&body) {
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers.size(); ++w)
+      threads.emplace_back([&, w] { work(w, body); });
+    work(0, body);
+    for (std::thread &T : threads)
+      T.join();
+  }
+
+private:
+  struct Worker {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+  };
+
+  template <typename Body> void work(unsigned self, Body &body) {
+    size_t task;
+    while (popOwn(self, task) || steal(self, task))
+      body(task);
+  }
+
+  bool popOwn(unsigned self, size_t &task) {
+    Worker &W = *workers[self];
+    std::lock_guard<std::mutex> guard(W.lock);
+    if (W.tasks.empty())
+      return false;
+    task = W.tasks.front();
+    W.tasks.pop_front();
+    return true;
+  }
+
+  bool steal(unsigned self, size_t &task) {
+    for (size_t i = 1; i < workers.size(); ++i) {
+      Worker &Victim = *workers[(self + i) % workers.size()];
+      std::lock_guard<std::mutex> guard(Victim.lock);
+      if (!Victim.tasks.empty()) {
+        task = Victim.tasks.back();
+        Victim.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers;
+};
+
+} // anonymous namespace
+
+ParallelPathEnumerator::ParallelPathEnumerator(
+    std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+    size_t maxLoopIterations, unsigned numThreads)
+    : ParallelPathEnumerator(std::move(CFG),
+                             EnumerationBudget{maxPaths, maxLoopIterations},
+                             numThreads) {}
+
+ParallelPathEnumerator::ParallelPathEnumerator(
+    std::shared_ptr<const CFGIndex> CFG, const EnumerationBudget &budget,
+    unsigned numThreads)
+    : CFG(std::move(CFG)), maxPaths(budget.maxPaths),
+      maxLoopIterations(budget.maxLoopIterations), timeMs(budget.timeMs),
+      memBytes(budget.memBytes), numThreads(numThreads), numTasks(0),
+      limitHit(BudgetLimit::None) {
+  if (this->numThreads == 0)
+    this->numThreads = hardware_concurrency().compute_thread_count();
+  this->numThreads = std::max(this->numThreads, 1u);
+}
+
+// Follow single-successor blocks: they do not create parallelism, so a task
+// boundary there would only duplicate the prefix. Returns false if the chain
+// runs into the loop iteration bound, i.e. the prefix has no paths.
+bool ParallelPathEnumerator::extendChain(std::vector<uint32_t> &prefix) const {
+  while (CFG->successors(prefix.back()).size() == 1) {
+    uint32_t succ = CFG->successors(prefix.back()).front();
+    if (static_cast<size_t>(llvm::count(prefix, succ)) > maxLoopIterations)
+      return false;
+    prefix.push_back(succ);
+  }
+  return true;
+}
+
+std::vector<std::vector<uint32_t>>
+ParallelPathEnumerator::splitIntoTasks(size_t targetTasks) const {
+  std::vector<std::vector<uint32_t>> tasks;
+  std::vector<uint32_t> root = {0};
+  if (extendChain(root))
+    tasks.push_back(std::move(root));
+
+  // Replace every prefix by its children, in successor order. This keeps the
+  // task list in DFS order, so concatenating the task results in order gives
+  // the sequential enumeration order.
+  for (unsigned round = 0; round < MaxSplitRounds && !tasks.empty() &&
+                           tasks.size() < targetTasks;
+       ++round) {
+    std::vector<std::vector<uint32_t>> split;
+    bool expanded = false;
+    for (std::vector<uint32_t> &prefix : tasks) {
+      if (CFG->isExit(prefix.back())) {
+        split.push_back(std::move(prefix));
+        continue;
+      }
+
+      expanded = true;
+      for (uint32_t succ : CFG->successors(prefix.back())) {
+        // Same loop iteration bound as PathStream
+        if (static_cast<size_t>(llvm::count(prefix, succ)) > maxLoopIterations)
+          continue;
+        std::vector<uint32_t> child = prefix;
+        child.push_back(succ);
+        if (extendChain(child))
+          split.push_back(std::move(child));
+      }
+    }
+    tasks.swap(split);
+    if (!expanded)
+      break;
+  }
+  return tasks;
+}
+
+PathStore ParallelPathEnumerator::run() {
+  PathStore paths(CFG);
+  limitHit = BudgetLimit::None;
+  if (CFG->empty())
+    return paths;
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeMs);
+  std::vector<std::vector<uint32_t>> tasks =
+      splitIntoTasks(numThreads * TasksPerThread);
+  numTasks = tasks.size();
+
+  // Nothing to gain from threads: enumerate in place
+  if (numThreads == 1 || numTasks < 2) {
+    PathStream S(CFG, maxPaths, maxLoopIterations);
+    if (timeMs)
+      S.setDeadline(deadline);
+    while (S.next()) {
+      paths.append(S.currentIndices());
+      if (memBytes && paths.getMemoryUsage() > memBytes) {
+        limitHit = BudgetLimit::Memory;
+        return paths;
+      }
+    }
+    if (S.hasReachedLimit())
+      limitHit = BudgetLimit::Paths;
+    else if (S.hasExpired())
+      limitHit = BudgetLimit::Time;
+    return paths;
+  }
+
+  // Paths of each task, built by whichever thread runs it
+  std::vector<PathStore> buffers(numTasks, PathStore(CFG));
+  std::vector<bool> finished(numTasks, false);
+
+  // Tasks after 'cutoff' are not needed: the paths of the tasks up to and
+  // including it already exceed maxPaths
+  std::atomic<size_t> cutoff(numTasks);
+  std::atomic<size_t> totalPaths(0);
+  // Bytes held by all task buffers, and the budget that stopped every task
+  std::atomic<uint64_t> totalMemory(0);
+  std::atomic<BudgetLimit> stop(BudgetLimit::None);
+  std::mutex progressLock;
+  size_t completedPrefix = 0;
+  size_t completedPaths = 0;
+
+  auto runTask = [&](size_t task) {
+    if (task > cutoff.load(std::memory_order_relaxed) ||
+        stop.load(std::memory_order_relaxed) != BudgetLimit::None)
+      return;
+
+    // One path more than the limit tells us whether the limit was reached
+    PathStore &buffer = buffers[task];
+    size_t taskLimit = maxPaths == SIZE_MAX ? maxPaths : maxPaths + 1;
+    PathStream S(CFG, taskLimit, maxLoopIterations, tasks[task]);
+    if (timeMs)
+      S.setDeadline(deadline);
+    while (S.next()) {
+      size_t memoryBefore = buffer.getMemoryUsage();
+      buffer.append(S.currentIndices());
+      totalPaths.fetch_add(1, std::memory_order_relaxed);
+
+      size_t growth = buffer.getMemoryUsage() - memoryBefore;
+      if (memBytes && growth &&
+          totalMemory.fetch_add(growth, std::memory_order_relaxed) + growth >
+              memBytes) {
+        stop.store(BudgetLimit::Memory, std::memory_order_relaxed);
+        return;
+      }
+      if (buffer.size() % 64 == 0 &&
+          (task > cutoff.load(std::memory_order_relaxed) ||
+           stop.load(std::memory_order_relaxed) != BudgetLimit::None))
+        return;
+    }
+    if (S.hasExpired()) {
+      stop.store(BudgetLimit::Time, std::memory_order_relaxed);
+      return;
+    }
+
+    // Advance the completed prefix of the task list
+    std::lock_guard<std::mutex> guard(progressLock);
+    finished[task] = true;
+    while (completedPrefix < numTasks &&
+           completedPrefix <= cutoff.load(std::memory_order_relaxed) &&
+           finished[completedPrefix]) {
+      completedPaths += buffers[completedPrefix].size();
+      if (completedPaths > maxPaths)
+        cutoff.store(completedPrefix, std::memory_order_relaxed);
+      completedPrefix++;
+    }
+  };
+
+  WorkStealingPool Pool(std::min<size_t>(numThreads, numTasks), numTasks);
+  Pool.run(runTask);
+
+  // Deterministic merge in task order: each task is one block copy
+  size_t last = std::min(cutoff.load(), numTasks - 1);
+  size_t numBlocks = 0;
+  for (size_t task = 0; task <= last; ++task)
+    numBlocks += buffers[task].getNumBlocks();
+  paths.reserve(std::min(totalPaths.load(), maxPaths), numBlocks);
+  for (size_t task = 0; task <= last; ++task) {
+    size_t room = maxPaths - paths.size();
+    if (buffers[task].size() > room) {
+      paths.append(buffers[task], room);
+      limitHit = BudgetLimit::Paths;
+      return paths;
+    }
+    paths.append(buffers[task], buffers[task].size());
+
+    // A stopped task holds a prefix of its subtree; later tasks would leave
+    // a gap in the enumeration order
+    if (!finished[task]) {
+      limitHit = stop.load();
+      return paths;
+    }
+  }
+  return paths;
+}
@@ -1,6 +1,7 @@
 #include "llvm/Passes/PassPlugin.h"
 #include "CriticalSection.h"
 #include "CriticalSectionTraversal.h"
+#include "EnumerationBudget.h"
 #include "FeedbackResonance.h"
 #include "FlowDensity.h"
 #include "InterProcFanOut.h"
@@ -10,19 +11,60 @@
 #include "PathBasedFlowDensity.h"
 #include "PathBasedInterProcFanOut.h"
 #include "PathBasedMaxPath.h"
+#include "PathEnumeratorAnalysis.h"
 #include "PathEnumeratorPass.h"
 #include "llvm/Passes/PassBuilder.h"
 
 using namespace llvm;
 
+// Match a path-based pass, optionally with enumeration limits given as
+// "name<max-paths=N;time-ms=N;mem-mb=N>". Limits that are not given keep the
+// values already in Budget. Parameters that are options of the pass rather
+// than limits go to Option, which returns whether it took them.
+static bool parsePathBasedPass(
+    StringRef Name, StringRef PassName, hepf::EnumerationBudget &Budget,
+    function_ref<bool(StringRef)> Option = [](StringRef) { return false; }) {
+  StringRef Params;
+  if (!hepf::matchPassName(Name, PassName, Params))
+    return false;
+  SmallVector<StringRef, 8> Parts;
+  SmallVector<StringRef, 8> Limits;
+  Params.split(Parts, ';', -1, /*KeepEmpty=*/false);
+  for (StringRef Part : Parts) {
+    if (!Option(Part))
+      Limits.push_back(Part);
+  }
+  std::optional<hepf::EnumerationBudget> Parsed =
+      Budget.parse(join(Limits, ";"));
+  if (!Parsed) {
+    errs() << "Invalid parameters for " << PassName << ": '" << Params
+           << "'\n";
+    return false;
+  }
+  Budget = *Parsed;
+  return true;
+}
+
 extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo
 llvmGetPassPluginInfo() {
   return {LLVM_PLUGIN_API_VERSION, "HepfCore", "v0.1.0", [](PassBuilder &PB) {
+            // Path enumerations cached per function for the path-based passes
+            PB.registerAnalysisRegistrationCallback(
+                [](FunctionAnalysisManager &FAM) {
+                  FAM.registerPass([] { return hepf::PathEnumeratorAnalysis(); });
+                });
             PB.registerPipelineParsingCallback(
                 [](StringRef Name, ModulePassManager &MPM,
                    ArrayRef<PassBuilder::PipelineElement>) {
-                  if (Name == "max-path") {
-                    MPM.addPass(MaxPathPass());
+                  StringRef Params;
+                  if (hepf::matchPassName(Name, "max-path", Params)) {
+                    auto Opts = MaxPathPass::Options().parse(Params);
+                    if (!Opts) {
+                      errs() << "Invalid parameters for max-path: '" << Params
+                             << "'\n";
+                      return false;
+                    }
+                    MPM.addPass(MaxPathPass(*Opts));
                     return true;
                   }
                   if (Name == "inter-proc-fan-out") {
@@ -48,24 +90,68 @@ llvmGetPassPluginInfo() {
                     MPM.addPass(hepf::FeedbackResonance());
                     return true;
                   }
-                  if (Name == "path-enumerator") {
-                    MPM.addPass(hepf::PathEnumeratorPass(1000, 2));
+                  hepf::EnumerationBudget Budget{1000, 2};
+                  // paths-out=DIR and paths-in=DIR name files rather than
+                  // limits, so they are not part of the budget
+                  std::string PathsOut, PathsIn;
+                  auto PathFiles = [&](StringRef Part) {
+                    if (Part.consume_front("paths-out="))
+                      PathsOut = Part.str();
+                    else if (Part.consume_front("paths-in="))
+                      PathsIn = Part.str();
+                    else
+                      return false;
+                    return true;
+                  };
+                  if (parsePathBasedPass(Name, "path-enumerator", Budget,
+                                         PathFiles)) {
+                    hepf::PathEnumeratorPass Pass(Budget);
+                    Pass.PathsOut = PathsOut;
+                    Pass.PathsIn = PathsIn;
+                    MPM.addPass(std::move(Pass));
                     return true;
                   }
-                  if (Name == "path-based-max-path") {
-                    MPM.addPass(hepf::PathBasedMaxPathPass());
+                  Budget = {5000, 1};
+                  if (parsePathBasedPass(Name, "path-based-max-path", Budget)) {
+                    MPM.addPass(hepf::PathBasedMaxPathPass(Budget));
                     return true;
                   }
-                  if (Name == "path-based-inter-proc-fan-out") {
-                    MPM.addPass(hepf::PathBasedInterProcFanOutPass());
+                  Budget = {5000, 1};
+                  // per-path evaluates every path from scratch, to check the
+                  // batched and incremental evaluations against
+                  bool PerPath = false;
+                  auto PerPathOption = [&](StringRef Part) {
+                    if (Part != "per-path")
+                      return false;
+                    PerPath = true;
+                    return true;
+                  };
+                  if (parsePathBasedPass(Name, "path-based-inter-proc-fan-out",
+                                         Budget, PerPathOption)) {
+                    hepf::PathBasedInterProcFanOutPass Pass(Budget);
+                    Pass.PerPath = PerPath;
+                    MPM.addPass(std::move(Pass));
                     return true;
                   }
-                  if (Name == "path-based-critical-section-traversal") {
-                    MPM.addPass(hepf::PathBasedCriticalSectionTraversalPass(10000, 2));
+                  Budget = {10000, 2};
+                  if (parsePathBasedPass(
+                          Name, "path-based-critical-section-traversal",
+                          Budget)) {
+                    MPM.addPass(
+                        hepf::PathBasedCriticalSectionTraversalPass(Budget));
                     return true;
                   }
-                  if (Name == "path-based-flow-density") {
-                    MPM.addPass(hepf::PathBasedFlowDensityPass(1000, 2));
+                  Budget = {1000, 2};
+                  if (parsePathBasedPass(Name, "path-based-flow-density",
+                                         Budget)) {
+                    // The path trie is built over CFG nodes, which would be
+                    // chains rather than blocks
+                    if (Budget.superblocks) {
+                      errs() << "path-based-flow-density does not support "
+                                "superblocks\n";
+                      return false;
+                    }
+                    MPM.addPass(hepf::PathBasedFlowDensityPass(Budget));
                     return true;
                   }
                   if (Name == "path-based-feedback-resonance") {
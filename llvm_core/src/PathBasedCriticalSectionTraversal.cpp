@@ -1,10 +1,18 @@
 #include "PathBasedCriticalSectionTraversal.h"
+#include "ChainSummary.h"
+#include "PathCounter.h"
 #include "PathEnumerator.h"
+#include "PathEnumeratorAnalysis.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <climits>
 #include <set>
+#include <tuple>
 
 using namespace llvm;
 using namespace hepf;
@@ -19,6 +27,111 @@ static const std::set<StringRef> LockFunctions = {
 static const std::set<StringRef> UnlockFunctions = {
     "mutex_unlock", "spin_unlock", "pthread_mutex_unlock", "release_lock"};
 
+// Net change of the critical section depth over one basic block
+static int getLockDelta(BasicBlock *bb) {
+  int delta = 0;
+  for (auto &I : *bb) {
+    if (auto *call = dyn_cast<CallInst>(&I)) {
+
+      // Check for direct calls only (Still ignores indirect calls, a
+      // known limitation)
+      if (Function *calledFunc = call->getCalledFunction()) {
+        StringRef name = calledFunc->getName();
+
+        // Check if the call is a LOCK operation
+        if (LockFunctions.count(name)) {
+          delta++;
+        }
+        // Check if the call is an UNLOCK operation
+        else if (UnlockFunctions.count(name)) {
+          delta--;
+        }
+      }
+    }
+  }
+  return delta;
+}
+
+namespace {
+
+// Lock depths beyond this are merged into it, so that a loop that locks on
+// every iteration still has finitely many depth states
+static constexpr int MaxTrackedDepth = 64;
+
+// Reachable (node, depth) states, where depth is the lock depth after the
+// node. A BFS evaluates each distinct state once, so the work is bounded by
+// nodes x distinct depths rather than by the number of paths, and loops are
+// covered for any number of iterations. Parent links give a witness path.
+//
+// A depth merged at +-MaxTrackedDepth is no longer the depth of the path, so
+// states reached over a merge are kept apart as approximate: their exit
+// depths are not reported, and they are never a witness.
+struct LockDepthStates {
+  static constexpr uint32_t None = UINT32_MAX;
+
+  struct State {
+    uint32_t node;
+    int depth;
+    uint32_t parent;
+    bool approximate;
+  };
+
+  std::vector<State> states;
+  // Over the exit states that are not approximate
+  int minExitDepth = INT_MAX;
+  int maxExitDepth = INT_MIN;
+  // Exit states reached over a merged depth
+  size_t approximateExits = 0;
+  // First unbalanced exit state, reached over the fewest nodes
+  uint32_t witness = None;
+
+  LockDepthStates(const CFGIndex &CFG, ArrayRef<ChainSummary> Summaries) {
+    DenseMap<std::tuple<uint32_t, int, unsigned>, uint32_t> seen;
+    auto visit = [&](uint32_t node, int depth, uint32_t parent,
+                     bool approximate) {
+      if (depth > MaxTrackedDepth || depth < -MaxTrackedDepth) {
+        depth = std::clamp(depth, -MaxTrackedDepth, MaxTrackedDepth);
+        approximate = true;
+      }
+      auto key = std::make_tuple(node, depth, unsigned(approximate));
+      if (seen.insert({key, uint32_t(states.size())}).second)
+        states.push_back({node, depth, parent, approximate});
+    };
+
+    visit(0, Summaries[0].lockDelta, None, false);
+    for (uint32_t i = 0; i < states.size(); ++i) {
+      State S = states[i];
+      if (CFG.isExit(S.node)) {
+        if (S.approximate) {
+          approximateExits++;
+          continue;
+        }
+        minExitDepth = std::min(minExitDepth, S.depth);
+        maxExitDepth = std::max(maxExitDepth, S.depth);
+        if (S.depth != 0 && witness == None)
+          witness = i;
+        continue;
+      }
+      for (uint32_t succ : CFG.successors(S.node))
+        visit(succ, S.depth + Summaries[succ].lockDelta, i, S.approximate);
+    }
+  }
+
+  bool hasExactExit() const { return minExitDepth <= maxExitDepth; }
+  bool hasExit() const { return hasExactExit() || approximateExits > 0; }
+
+  // Nodes from the entry to the given state
+  std::vector<uint32_t> getPath(uint32_t state) const {
+    std::vector<uint32_t> path;
+    for (uint32_t s = state; s != None; s = states[s].parent)
+      path.push_back(states[s].node);
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+};
+
+} // anonymous namespace
+
 // ---
 
 // -----------------------------------------------------------
@@ -27,15 +140,16 @@ static const std::set<StringRef> UnlockFunctions = {
 PathBasedCriticalSectionTraversalPass::PathBasedCriticalSectionTraversalPass(
     size_t maxPaths,
     size_t maxLoopIterations)
-    : MaxPaths(maxPaths),
-      MaxLoopIterations(maxLoopIterations)
+    : Budget{maxPaths, maxLoopIterations}
 {
     // Difinition of the constructor.
 }
 
 PreservedAnalyses
-PathBasedCriticalSectionTraversalPass::run(Module &M, ModuleAnalysisManager &) {
+PathBasedCriticalSectionTraversalPass::run(Module &M,
+                                           ModuleAnalysisManager &AM) {
 
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
   size_t auto_count = 0;
   for (auto &F : M) {
       auto_count++;
@@ -44,42 +158,50 @@ PathBasedCriticalSectionTraversalPass::run(Module &M, ModuleAnalysisManager &) {
       continue;
     }
 
-    // 1. Initialize the PathEnumerator with the function and the path limit.
-    PathEnumerator PE(F, MaxPaths, MaxLoopIterations);
+    // 1. Count the paths to decide whether to list them; the lock depth
+    // states below cover every path either way.
+    PathCounter PC(F, FAM.getResult<LoopAnalysis>(F),
+                   Budget.maxLoopIterations, Budget.uniqueSuccessors,
+                   Budget.pruneCold);
+    EnumerationPlan Plan =
+        EnumerationPlan::choose(PC, Budget.maxPaths, Budget.isBestFirst())
+            .withoutSampling();
+    errs() << "Function: " << F.getName() << ", Enumeration mode: ";
+    Plan.print(errs());
+    errs() << "\n";
+    if (Plan.mode == EnumerationPlan::Skipped) {
+      continue;
+    }
 
-    unsigned path_count = 0;
+    auto &PEA = FAM.getResult<PathEnumeratorAnalysis>(F);
+    const std::shared_ptr<const CFGIndex> &CFG = PEA.getCFG(Budget);
 
-    // Use the iterator returned by getPaths().
-    for (const auto &path : PE.getPaths()) {
+    // Lock deltas per CFG node, so that a path costs one addition per node
+    // (per straight-line chain with superblocks) rather than a block scan
+    std::vector<ChainSummary> Summaries = summarizeChains(*CFG, getLockDelta);
+    auto getPathDepth = [&](PathView path) {
+      int depth = 0;
+      for (uint32_t node : path.getBlockIndices()) {
+        depth += Summaries[node].lockDelta;
+      }
+      return depth;
+    };
 
-      // Critical Section Depth: 0 = outside, 1+ = inside.
-      int criticalSectionDepth = 0;
+    // 2. Get the paths of the function for our limits (cached across passes),
+    // unless there are too many to enumerate.
+    const PathEnumerator *PE = nullptr;
+    if (Plan.enumerates()) {
+      PE = &PEA.get(Budget, FAM);
+    }
+    const PathStore NoPaths(CFG);
+    const PathStore &Paths = PE ? PE->getPathStore() : NoPaths;
 
-      // Core analysis: Iterate through instructions in each basic block of the
-      // path
-      for (auto *bb : path) {
-        for (auto &I : *bb) {
-          if (auto *call = dyn_cast<CallInst>(&I)) {
-
-            // Check for direct calls only (Still ignores indirect calls, a
-            // known limitation)
-            if (Function *calledFunc = call->getCalledFunction()) {
-              StringRef name = calledFunc->getName();
-
-              // Check if the call is a LOCK operation
-              if (LockFunctions.count(name)) {
-                criticalSectionDepth++;
-              }
-              // Check if the call is an UNLOCK operation
-              else if (UnlockFunctions.count(name)) {
-                criticalSectionDepth--;
-              }
-            }
-          }
-        }
-      }
+    for (PathView path : Paths) {
+
+      // Critical Section Depth: 0 = outside, 1+ = inside.
+      int criticalSectionDepth = getPathDepth(path);
 
-      // 2. Report Analysis Results
+      // 3. Report Analysis Results
       errs() << "Function: " << F.getName() << ", Path (BBs): [";
 
       bool first = true;
@@ -95,20 +217,62 @@ PathBasedCriticalSectionTraversalPass::run(Module &M, ModuleAnalysisManager &) {
 
       errs() << ", Final Lock Depth: " << criticalSectionDepth;
 
-      // 3. Highlight potential critical problems
+      // 4. Highlight potential critical problems
       if (criticalSectionDepth != 0) {
         errs() << " **(WARNING: Unbalanced Lock/Unlock Pair)**";
       }
       errs() << "\n";
-
-      path_count++;
     }
 
-    // Output a warning if the path limit was reached.
-    if (path_count == MaxPaths) {
-      errs() << "WARNING: Path limit of " << MaxPaths
+    // Output a warning if the path limit was reached, i.e. more than
+    // maxPaths paths exist.
+    if (PE && PE->getLimitHit() == BudgetLimit::Paths) {
+      errs() << "WARNING: Path limit of " << Budget.maxPaths
              << " reached for function " << F.getName()
              << ". Analysis may be incomplete.\n";
+    } else if (PE && PE->hasReachedLimit()) {
+      errs() << "WARNING: ";
+      Budget.printLimitReached(errs(), PE->getLimitHit());
+      errs() << " for function " << F.getName()
+             << ". Analysis may be incomplete.\n";
+    }
+
+    // Every exit depth and a shortest witness path for an unbalanced one,
+    // from the lock depth states of the CFG
+    LockDepthStates DepthStates(*CFG, Summaries);
+    if (DepthStates.hasExit()) {
+      errs() << "Function: " << F.getName() << ", Lock Depth States: "
+             << DepthStates.states.size() << ", exit depths ";
+      if (DepthStates.hasExactExit()) {
+        errs() << "[" << DepthStates.minExitDepth << ", "
+               << DepthStates.maxExitDepth << "]";
+      } else {
+        errs() << "unknown";
+      }
+      // Paths over a merged depth may be balanced or not; say so instead of
+      // reporting them
+      if (DepthStates.approximateExits > 0) {
+        errs() << " (APPROXIMATE: depths beyond " << MaxTrackedDepth
+               << " merged; approximate exit states: "
+               << DepthStates.approximateExits << ")";
+      }
+      errs() << "\n";
+      if (DepthStates.witness != LockDepthStates::None) {
+        errs() << "Function: " << F.getName() << ", Witness Path (BBs): [";
+        bool first = true;
+        for (uint32_t node : DepthStates.getPath(DepthStates.witness)) {
+          for (auto *bb : CFG->getChain(node)) {
+            if (!first) {
+              errs() << " -> ";
+            }
+            bb->printAsOperand(errs(), false);
+            first = false;
+          }
+        }
+        errs() << "], Final Lock Depth: "
+               << DepthStates.states[DepthStates.witness].depth
+               << " **(WARNING: Unbalanced Lock/Unlock Pair)**\n";
+      }
     }
   }
 
@@ -1,12 +1,19 @@
 #include "PathBasedFlowDensity.h"
+#include "PathAlgebra.h"
+#include "PathCounter.h"
 #include "PathEnumerator.h"
+#include "PathExpression.h"
+#include "PathTrie.h"
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace llvm;
 using namespace hepf;
@@ -14,12 +21,22 @@ using namespace hepf;
 // -----------------------------------------------------------
 // Helper Functions
 // -----------------------------------------------------------
+// Probability of the first successor slot from Src to Dst, or with allSlots
+// of all of them, for paths over merged duplicate edges
 static double getEdgeProbability(BasicBlock *Src, BasicBlock *Dst,
-                                 BranchProbabilityInfo &BPI) {
+                                 BranchProbabilityInfo &BPI,
+                                 bool allSlots = false) {
   auto *Term = Src->getTerminator();
   if (!Term || Term->getNumSuccessors() == 0)
     return 0.0;
 
+  if (allSlots) {
+    BranchProbability BP = BPI.getEdgeProbability(Src, Dst);
+    if (BP.isUnknown())
+      return 0.0;
+    return static_cast<double>(BP.getNumerator()) / BP.getDenominator();
+  }
+
   for (unsigned i = 0, e = Term->getNumSuccessors(); i < e; ++i) {
     if (Term->getSuccessor(i) == Dst) {
       BranchProbability BP = BPI.getEdgeProbability(Src, i);
@@ -31,14 +48,81 @@ static double getEdgeProbability(BasicBlock *Src, BasicBlock *Dst,
   return 0.0;
 }
 
+namespace {
+
+// Sum of prob * entropy over a set of paths. A path's value is kept as
+// (prob, prob * entropy); since entropy adds and probability multiplies
+// along a path, concatenation is
+//   (p1, f1) . (p2, f2) = (p1 * p2, f1 * p2 + p1 * f2)
+// which distributes over the sum of alternatives, so the total composes
+// over the path expression of the function.
+struct FlowDensityAlgebra {
+  struct Value {
+    double prob;
+    double flow;
+  };
+
+  BranchProbabilityInfo &BPI;
+  const DenseMap<BasicBlock *, float> &bbEntropy;
+
+  Value block(BasicBlock *BB) const { return {1.0, bbEntropy.lookup(BB)}; }
+  // A path expression edge stands for all of its parallel slots
+  Value edge(BasicBlock *Src, BasicBlock *Dst) const {
+    return {getEdgeProbability(Src, Dst, BPI, /*allSlots=*/true), 0.0};
+  }
+  Value concat(Value A, Value B) const {
+    return {A.prob * B.prob, A.flow * B.prob + A.prob * B.flow};
+  }
+  Value join(Value A, Value B) const {
+    return {A.prob + B.prob, A.flow + B.flow};
+  }
+  // Geometric series over the iterations of a cycle: sum_k (p, f)^k with
+  // (p, f)^k = (p^k, k p^(k-1) f), which converges for p < 1
+  Value star(Value A) const {
+    if (A.prob >= 1.0)
+      return {HUGE_VAL, HUGE_VAL};
+    double stay = 1.0 / (1.0 - A.prob);
+    return {stay, A.flow * stay * stay};
+  }
+};
+
+// Moments of the path entropy weighted by path probability, for PathAlgebra:
+// (prob, prob * entropy, prob * entropy^2) summed over a set of paths
+struct EntropyMoments {
+  struct Value {
+    double prob;
+    double flow;
+    double flowSquares;
+  };
+
+  BranchProbabilityInfo &BPI;
+  bool allSlots;
+
+  Value lift(double entropy) const {
+    return {1.0, entropy, entropy * entropy};
+  }
+  Value edge(BasicBlock *Src, BasicBlock *Dst) const {
+    return {getEdgeProbability(Src, Dst, BPI, allSlots), 0.0, 0.0};
+  }
+  Value concat(const Value &A, const Value &B) const {
+    return {A.prob * B.prob, A.flow * B.prob + A.prob * B.flow,
+            A.flowSquares * B.prob + 2.0 * A.flow * B.flow +
+                A.prob * B.flowSquares};
+  }
+  Value join(const Value &A, const Value &B) const {
+    return {A.prob + B.prob, A.flow + B.flow, A.flowSquares + B.flowSquares};
+  }
+};
+
+} // anonymous namespace
+
 // -----------------------------------------------------------
 // Main Pass
 // -----------------------------------------------------------
 PathBasedFlowDensityPass::PathBasedFlowDensityPass(
     size_t maxPaths,
     size_t maxLoopIterations)
-    : MaxPaths(maxPaths),
-      MaxLoopIterations(maxLoopIterations)
+    : Budget{maxPaths, maxLoopIterations}
 {
     // Definition of the constructor.
 }
@@ -56,7 +140,8 @@ PreservedAnalyses PathBasedFlowDensityPass::run(Module &M,
     // Required analysis
     auto &BPI = FAM.getResult<BranchProbabilityAnalysis>(F);
 
-    runOnFunction(F, BPI);
+    runOnFunction(F, BPI, FAM.getResult<PathEnumeratorAnalysis>(F),
+                  FAM.getResult<LoopAnalysis>(F));
   }
 
   return PreservedAnalyses::all();
@@ -64,9 +149,30 @@ PreservedAnalyses PathBasedFlowDensityPass::run(Module &M,
 
 // ------------------------------------------------------------
 // Per-function implementation (now properly declared in the class)
-void PathBasedFlowDensityPass::runOnFunction(Function &F,
-                                             BranchProbabilityInfo &BPI) {
-  PathEnumerator PE(F, MaxPaths, MaxLoopIterations);
+void PathBasedFlowDensityPass::runOnFunction(
+    Function &F, BranchProbabilityInfo &BPI,
+    PathEnumeratorAnalysis::Result &Paths, LoopInfo &LI) {
+  // Count the paths to decide whether to list them; the totals below come
+  // from a DP over the CFG either way
+  PathCounter PC(F, LI, Budget.maxLoopIterations, Budget.uniqueSuccessors,
+                 Budget.pruneCold);
+  EnumerationPlan Plan =
+      EnumerationPlan::choose(PC, Budget.maxPaths, Budget.isBestFirst())
+          .withoutSampling();
+  const PathEnumerator *PE = nullptr;
+  if (Plan.enumerates())
+    PE = &Paths.get(Budget, &BPI);
+
+  errs() << "=== Path-Based Flow Density for '" << F.getName() << "' ===\n";
+  errs() << "  Enumeration mode: ";
+  Plan.print(errs());
+  errs() << "\n";
+  if (Plan.mode == EnumerationPlan::Skipped) {
+    errs() << "\n";
+    return;
+  }
+  const PathStore NoPaths(Paths.getCFG(Budget));
+  PathTrie Trie(PE ? PE->getPathStore() : NoPaths);
 
   // Dummy entropy = number of instructions (replace with real entropy if
   // desired)
@@ -74,35 +180,42 @@ void PathBasedFlowDensityPass::runOnFunction(Function &F,
   for (BasicBlock &BB : F)
     bbEntropy[&BB] = static_cast<float>(BB.size());
 
-  errs() << "=== Path-Based Flow Density for '" << F.getName() << "' ===\n";
-
-  for (const auto &Path : PE.getPaths()) {
-    if (Path.empty())
-      continue;
-
-    double pathProb = 1.0;
-    float pathEntropy = 0.0f;
-
-    // Sum entropy of all blocks in the path
-    for (BasicBlock *BB : Path)
-      pathEntropy += bbEntropy.lookup(BB);
-
-    // Multiply edge probabilities
-    for (size_t i = 0; i + 1 < Path.size(); ++i) {
-      double p = getEdgeProbability(Path[i], Path[i + 1], BPI);
-      if (p <= 0.0) { // unknown or zero probability → skip path
-        pathProb = 0.0;
-        break;
-      }
-      pathProb *= p;
-    }
+  // Probability and entropy of every path prefix. Paths share their
+  // prefixes in the trie, so each edge probability is looked up once per
+  // trie node instead of once per path through it.
+  struct PrefixFlow {
+    double prob;
+    float entropy;
+  };
+  std::vector<PrefixFlow> prefixes = Trie.computePrefixValues<PrefixFlow>(
+      [&](uint32_t node) {
+        return PrefixFlow{1.0, bbEntropy.lookup(Trie.getBlock(node))};
+      },
+      [&](const PrefixFlow &parent, uint32_t node) {
+        BasicBlock *BB = Trie.getBlock(node);
+        double prob = 0.0;
+        // unknown or zero probability → skip path
+        if (parent.prob != 0.0) {
+          BasicBlock *Pred = Trie.getBlock(Trie.getNode(node).parent);
+          double p =
+              getEdgeProbability(Pred, BB, BPI, Budget.uniqueSuccessors);
+          if (p > 0.0)
+            prob = parent.prob * p;
+        }
+        return PrefixFlow{prob, parent.entropy + bbEntropy.lookup(BB)};
+      });
 
+  Path Path;
+  for (uint32_t leaf : Trie.getLeaves()) {
+    double pathProb = prefixes[leaf].prob;
+    float pathEntropy = prefixes[leaf].entropy;
     double flowDensity = pathProb * pathEntropy;
 
     errs() << "  Prob: " << format("%.6f", pathProb)
            << " | Entropy: " << format("%.2f", pathEntropy)
            << " | FlowDensity: " << format("%.6e", flowDensity) << "\n";
 
+    Trie.getPath(leaf, Path);
     errs() << "    Path: [";
     for (size_t i = 0; i < Path.size(); ++i) {
       BasicBlock *BB = Path[i];
@@ -115,5 +228,49 @@ void PathBasedFlowDensityPass::runOnFunction(Function &F,
     }
     errs() << "]\n";
   }
+
+  // The prefix values above cost one step per trie node rather than per
+  // block of every path
+  if (Trie.getPathCount() > 0) {
+    const PathStore &Stored = PE ? PE->getPathStore() : NoPaths;
+    errs() << "  Path trie: " << Trie.getNumNodes() << " nodes for "
+           << Trie.getPathCount() << " paths of " << Stored.getNumBlocks()
+           << " blocks in total\n";
+  }
+
+  // Totals over all paths by a DP over the CFG instead of sums over the
+  // enumerated paths, so they are not cut by the path limit
+  const CFGIndex &CFG = *Paths.getCFG(Budget);
+  PathAlgebra Moments(
+      EntropyMoments{BPI, Budget.uniqueSuccessors},
+      [&](BasicBlock *BB) { return double(bbEntropy.lookup(BB)); });
+  if (auto total = Moments.solve(CFG, LI, Budget.maxLoopIterations)) {
+    errs() << "  Total FlowDensity (all paths, DP over " << CFG.size()
+           << " blocks): " << format("%.6e", total->flow) << "\n";
+    // Paths cut by the loop bound carry no probability here, so the moments
+    // are over the probability that is covered
+    if (total->prob > 0.0) {
+      double mean = total->flow / total->prob;
+      double variance =
+          std::max(0.0, total->flowSquares / total->prob - mean * mean);
+      errs() << "  Path entropy (by probability, "
+             << format("%.6f", total->prob) << " covered): mean "
+             << format("%.2f", mean) << ", std dev "
+             << format("%.2f", std::sqrt(variance)) << "\n";
+    }
+  }
+
+  // The same total over the path expression, with every loop taken any
+  // number of times: the expected entropy of an execution, in closed form
+  PathExpression PX(Paths.getCFG(Budget));
+  if (auto total = PX.evaluate(FlowDensityAlgebra{BPI, bbEntropy}))
+    errs() << "  Total FlowDensity (loop-exact, path expression of "
+           << PX.size() << " nodes): " << format("%.6e", total->flow) << "\n";
+
+  if (PE && PE->hasReachedLimit()) {
+    errs() << "  ";
+    Budget.printLimitReached(errs(), PE->getLimitHit());
+    errs() << "; paths listed above are incomplete\n";
+  }
   errs() << "\n";
 }
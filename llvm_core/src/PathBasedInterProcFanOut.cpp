@@ -1,158 +1,445 @@
 #include "PathBasedInterProcFanOut.h"
+#include "PathCounter.h"
 #include "PathEnumerator.h"
+#include "PathEnumeratorAnalysis.h"
+#include "PathSampler.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
-#include <unordered_set>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 
 using namespace llvm;
 using namespace hepf;
 
+// Random paths drawn when exhaustive enumeration is not possible
+static constexpr size_t NumSampledPaths = 1000;
+
+// Input functions produce tainted data
+static bool isInputFunction(StringRef Name) {
+  return Name.contains("read") || Name.contains("recv") ||
+         Name.contains("get") || Name.contains("scan") ||
+         Name.contains("input") || Name.contains("fread") ||
+         Name.contains("getchar") || Name.contains("fgets");
+}
+
+// Whether taint flows from operand U into the value of its user I (PHIs
+// aside, whose taint depends on the incoming edge)
+static bool propagatesTaint(const Use &U) {
+  auto *I = cast<Instruction>(U.getUser());
+  if (auto *Load = dyn_cast<LoadInst>(I)) {
+    // If loading from a tainted address, result is tainted
+    return U.get() == Load->getPointerOperand();
+  }
+  if (isa<StoreInst>(I)) {
+    // Store doesn't produce a value, but taints memory location
+    // This is tracked separately
+    return false;
+  }
+  if (isa<CallInst>(I)) {
+    // If any argument is tainted, result might be tainted (conservative
+    // assumption); this covers indirect calls through a tainted pointer
+    return true;
+  }
+  // For most instructions, if any operand is tainted, result is tainted
+  return !I->getType()->isVoidTy();
+}
+
 namespace {
 
-// Proper taint analysis within a path
-class PathTaintAnalysis {
+// Taint of the SSA values of a function, computed once by a sparse worklist
+// over the def-use graph instead of per path.
+//
+// In SSA form every operand of a non-PHI instruction on a path is defined
+// earlier on the same path, so its taint only depends on the path through
+// PHIs. A value is therefore either unconditionally tainted (reached from the
+// arguments or input calls without crossing a PHI, or through PHIs all of
+// whose incoming values are), or tainted exactly when one of its gates is:
+// the nearest PHIs above it in the def-use graph that can carry taint. A
+// gate PHI is tainted on a path once the path enters its block over an edge
+// whose incoming value is tainted at that point.
+class SparseTaint {
 public:
-  PathTaintAnalysis(const Path &path) {
-    // Initialize: function arguments are tainted (user-controlled)
-    if (!path.empty() && path[0]->getParent()) {
-      Function *F = path[0]->getParent();
-      for (Argument &Arg : F->args()) {
-        tainted.insert(&Arg);
+  explicit SparseTaint(Function &F) {
+    // Unconditional taint: function arguments are tainted (user-controlled),
+    // and so are the results of input functions
+    SmallVector<Value *, 32> worklist;
+    auto addUnconditional = [&](Value *V) {
+      if (unconditional.insert(V).second) {
+        worklist.push_back(V);
       }
+    };
+    for (Argument &Arg : F.args()) {
+      addUnconditional(&Arg);
     }
+    for (Instruction &I : instructions(F)) {
+      if (auto *Call = dyn_cast<CallInst>(&I)) {
+        Function *Callee = Call->getCalledFunction();
+        if (Callee && isInputFunction(Callee->getName())) {
+          addUnconditional(Call);
+        }
+      }
+    }
+    while (!worklist.empty()) {
+      Value *V = worklist.pop_back_val();
+      for (Use &U : V->uses()) {
+        auto *I = dyn_cast<Instruction>(U.getUser());
+        if (!I) {
+          continue;
+        }
+        if (auto *Phi = dyn_cast<PHINode>(I)) {
+          if (llvm::all_of(Phi->incoming_values(), [&](Value *In) {
+                return unconditional.contains(In);
+              })) {
+            addUnconditional(Phi);
+          }
+        } else if (propagatesTaint(U)) {
+          addUnconditional(I);
+        }
+      }
+    }
+
+    // Gates: every PHI that can receive taint gates itself and the values
+    // it reaches without crossing another PHI
+    SmallVector<PHINode *, 16> phiWorklist;
+    auto addGatePhi = [&](PHINode *Phi) {
+      if (!unconditional.contains(Phi) && !gates.count(Phi)) {
+        gates[Phi].push_back(Phi);
+        phiWorklist.push_back(Phi);
+      }
+    };
+    for (Instruction &I : instructions(F)) {
+      if (auto *Phi = dyn_cast<PHINode>(&I)) {
+        if (llvm::any_of(Phi->incoming_values(), [&](Value *In) {
+              return unconditional.contains(In);
+            })) {
+          addGatePhi(Phi);
+        }
+      }
+    }
+    while (!phiWorklist.empty()) {
+      PHINode *Gate = phiWorklist.pop_back_val();
+      worklist.assign({Gate});
+      while (!worklist.empty()) {
+        Value *V = worklist.pop_back_val();
+        for (Use &U : V->uses()) {
+          auto *I = dyn_cast<Instruction>(U.getUser());
+          if (!I || unconditional.contains(I)) {
+            continue;
+          }
+          if (auto *Phi = dyn_cast<PHINode>(I)) {
+            addGatePhi(Phi);
+          } else if (propagatesTaint(U)) {
+            SmallVector<PHINode *, 2> &IG = gates[I];
+            if (!llvm::is_contained(IG, Gate)) {
+              IG.push_back(Gate);
+              worklist.push_back(I);
+            }
+          }
+        }
+      }
+    }
+  }
 
-    // Propagate taint through the path
-    for (BasicBlock *BB : path) {
+  bool isUnconditional(const Value *V) const {
+    return unconditional.contains(V);
+  }
+  // PHIs whose taint on a path taints V; a gate PHI is its own gate
+  ArrayRef<PHINode *> getGates(const Value *V) const {
+    auto It = gates.find(V);
+    if (It == gates.end()) {
+      return {};
+    }
+    return It->second;
+  }
+
+private:
+  DenseSet<const Value *> unconditional;
+  DenseMap<const Value *, SmallVector<PHINode *, 2>> gates;
+};
+
+// Fan-out along a path that grows and shrinks at its end, as a DFS over the
+// enumeration tree visits it. Entering a block marks the gate PHIs its
+// incoming edge taints and counts its calls against the facts of
+// SparseTaint; every set insertion goes to an undo log, and leaving the
+// block rolls the log back to where the block started.
+class PathFanOut {
+public:
+  explicit PathFanOut(const SparseTaint &Taint) : Taint(Taint) {}
+
+  // Blocks entered and not left yet
+  size_t getDepth() const { return marks.size(); }
+  // Fan-out of the current path
+  unsigned getFanOut() const { return fanOut; }
+
+  void enter(ArrayRef<BasicBlock *> blocks) {
+    marks.push_back({undoLog.size(), fanOut, last});
+    for (BasicBlock *BB : blocks) {
+      if (last) {
+        takeEdge(last, BB);
+      }
       for (Instruction &I : *BB) {
-        propagateTaint(&I);
+        countCall(&I);
       }
+      last = BB;
     }
   }
 
-  bool isTainted(Value *V) const { return tainted.count(V) > 0; }
+  void leave() {
+    Mark mark = marks.pop_back_val();
+    while (undoLog.size() > mark.logSize) {
+      Undo entry = undoLog.pop_back_val();
+      if (entry.callee) {
+        calledFunctions.erase(entry.callee);
+      } else {
+        taintedPhis.erase(entry.phi);
+      }
+    }
+    fanOut = mark.fanOut;
+    last = mark.last;
+  }
 
 private:
+  // One insertion into either set
+  struct Undo {
+    PHINode *phi;
+    Function *callee;
+  };
+  struct Mark {
+    size_t logSize;
+    unsigned fanOut;
+    BasicBlock *last;
+  };
+
   // -----------------------------------------------------------
   // Helper Functions
   // -----------------------------------------------------------
-  void propagateTaint(Instruction *I) {
-    bool anyOperandTainted = false;
-
-    // Check if any operand is tainted
-    for (Use &U : I->operands()) {
-      if (tainted.count(U.get())) {
-        anyOperandTainted = true;
-        break;
-      }
+  bool isTainted(const Value *V) const {
+    if (Taint.isUnconditional(V)) {
+      return true;
     }
+    return llvm::any_of(Taint.getGates(V), [&](PHINode *Gate) {
+      return taintedPhis.contains(Gate);
+    });
+  }
 
-    // Propagate taint based on instruction type
-    if (auto *Load = dyn_cast<LoadInst>(I)) {
-      // If loading from a tainted address, result is tainted
-      if (tainted.count(Load->getPointerOperand())) {
-        tainted.insert(Load);
-      }
-    } else if (auto *Store = dyn_cast<StoreInst>(I)) {
-      // Store doesn't produce a value, but taints memory location
-      // This is tracked separately
-    } else if (auto *Call = dyn_cast<CallInst>(I)) {
-      Function *Callee = Call->getCalledFunction();
-      if (Callee) {
-        StringRef Name = Callee->getName();
-        // Input functions produce tainted data
-        if (Name.contains("read") || Name.contains("recv") ||
-            Name.contains("get") || Name.contains("scan") ||
-            Name.contains("input") || Name.contains("fread") ||
-            Name.contains("getchar") || Name.contains("fgets")) {
-          tainted.insert(Call);
-        } else if (anyOperandTainted) {
-          // If any argument is tainted, result might be tainted
-          // (conservative assumption)
-          tainted.insert(Call);
-        }
-      } else if (anyOperandTainted) {
-        // Indirect call with tainted operands
-        tainted.insert(Call);
-      }
-    } else if (auto *Phi = dyn_cast<PHINode>(I)) {
-      // PHI node is tainted if any incoming value is tainted
-      for (unsigned i = 0; i < Phi->getNumIncomingValues(); ++i) {
-        if (tainted.count(Phi->getIncomingValue(i))) {
-          tainted.insert(Phi);
-          break;
-        }
+  // PHIs read their incoming values in parallel, before any of them is
+  // updated
+  void takeEdge(BasicBlock *Pred, BasicBlock *BB) {
+    SmallVector<PHINode *, 4> newlyTainted;
+    for (PHINode &Phi : BB->phis()) {
+      if (Taint.getGates(&Phi).empty() || taintedPhis.contains(&Phi)) {
+        continue;
       }
-    } else if (anyOperandTainted) {
-      // For most instructions, if any operand is tainted, result is tainted
-      if (!I->getType()->isVoidTy()) {
-        tainted.insert(I);
+      int index = Phi.getBasicBlockIndex(Pred);
+      if (index >= 0 && isTainted(Phi.getIncomingValue(index))) {
+        newlyTainted.push_back(&Phi);
       }
     }
+    for (PHINode *Phi : newlyTainted) {
+      taintedPhis.insert(Phi);
+      undoLog.push_back({Phi, nullptr});
+    }
   }
 
-  std::unordered_set<Value *> tainted;
-};
+  void countCall(Instruction *I) {
+    // Check for call instructions (both direct and indirect)
+    CallInst *Call = dyn_cast<CallInst>(I);
+    if (!Call)
+      return;
 
-// Calculate fan-out for a single path
-unsigned calculatePathFanOut(const Path &path) {
-  if (path.empty())
-    return 0;
+    Function *Callee = Call->getCalledFunction();
 
-  // First, perform taint analysis on this path
-  PathTaintAnalysis TaintAnalysis(path);
+    // Skip intrinsics but count other calls
+    if (Callee && Callee->isIntrinsic()) {
+      return;
+    }
 
-  unsigned fanOut = 0;
-  std::unordered_set<Function *> calledFunctions;
+    // Check if this call has tainted arguments
+    bool hasTaintedArg = false;
+    for (unsigned i = 0; i < Call->arg_size(); ++i) {
+      if (isTainted(Call->getArgOperand(i))) {
+        hasTaintedArg = true;
+        break;
+      }
+    }
 
-  for (BasicBlock *BB : path) {
-    for (Instruction &I : *BB) {
-      // Check for call instructions (both direct and indirect)
-      CallInst *Call = dyn_cast<CallInst>(&I);
-      if (!Call)
-        continue;
+    // Count this call if it has tainted arguments and it is either an
+    // indirect call (each occurrence counts) or a direct call to a function
+    // not counted yet on this path
+    if (!hasTaintedArg) {
+      return;
+    }
+    if (!Callee) {
+      fanOut++;
+    } else if (calledFunctions.insert(Callee).second) {
+      undoLog.push_back({nullptr, Callee});
+      fanOut++;
+    }
+  }
 
-      Function *Callee = Call->getCalledFunction();
+  const SparseTaint &Taint;
+  DenseSet<PHINode *> taintedPhis;
+  DenseSet<Function *> calledFunctions;
+  unsigned fanOut = 0;
+  BasicBlock *last = nullptr;
+  SmallVector<Undo, 64> undoLog;
+  SmallVector<Mark, 16> marks;
+};
 
-      // Skip intrinsics but count other calls
-      if (Callee && Callee->isIntrinsic()) {
-        continue;
+// Fan-out of up to 64 paths at once, for functions without cycles, where a
+// path visits every block at most once and in reverse post-order.
+//
+// Bit j of a mask stands for path j of the batch. The batch marks the blocks
+// and edges of its paths, and a single sweep over the union of its blocks in
+// reverse post-order then computes every gate PHI as a mask (the paths that
+// enter its block over an edge whose incoming value they taint) and every
+// call's tainted-argument mask, with word-wide AND/OR. A direct callee counts
+// once per path, so its masks are ORed over its call sites; the per-path
+// fan-outs are read back from the set bits at the end.
+class BatchFanOut {
+public:
+  static constexpr unsigned Width = 64;
+
+  BatchFanOut(const SparseTaint &Taint, const CFGIndex &CFG,
+              ArrayRef<uint32_t> rpo)
+      : Taint(Taint), CFG(CFG), rpo(rpo), nodeMasks(CFG.size(), 0) {}
+
+  // Fan-out of each of paths (at most Width) into fanOuts
+  void run(ArrayRef<ArrayRef<uint32_t>> paths,
+           MutableArrayRef<unsigned> fanOuts) {
+    assert(paths.size() <= Width && "batch too wide");
+    edgeMasks.clear();
+    phiMasks.clear();
+    calleeMasks.clear();
+    std::fill(nodeMasks.begin(), nodeMasks.end(), 0);
+    std::fill(fanOuts.begin(), fanOuts.end(), 0);
+
+    for (unsigned j = 0; j < paths.size(); ++j) {
+      uint64_t bit = uint64_t(1) << j;
+      ArrayRef<uint32_t> nodes = paths[j];
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        nodeMasks[nodes[i]] |= bit;
+        if (i > 0) {
+          edgeMasks[{CFG.getChain(nodes[i - 1]).back(),
+                     CFG.getBlock(nodes[i])}] |= bit;
+        }
       }
+    }
 
-      // For indirect calls, we count them if they have tainted operands
-      bool isIndirect = (Callee == nullptr);
-
-      // Check if this call has tainted arguments
-      bool hasTaintedArg = false;
-      for (unsigned i = 0; i < Call->arg_size(); ++i) {
-        Value *Arg = Call->getArgOperand(i);
-        if (TaintAnalysis.isTainted(Arg)) {
-          hasTaintedArg = true;
-          break;
+    for (uint32_t node : rpo) {
+      uint64_t mask = nodeMasks[node];
+      if (!mask) {
+        continue;
+      }
+      BasicBlock *Pred = nullptr;
+      for (BasicBlock *BB : CFG.getChain(node)) {
+        evaluatePhis(Pred, BB, mask);
+        for (Instruction &I : *BB) {
+          countCall(&I, mask, fanOuts);
         }
+        Pred = BB;
       }
+    }
 
-      // Count this call if:
-      // 1. It has tainted arguments, AND
-      // 2. We haven't counted this function yet (for direct calls), OR
-      //    it's an indirect call (count each occurrence)
-      if (hasTaintedArg) {
-        if (isIndirect) {
-          // For indirect calls, count each occurrence
-          fanOut++;
-        } else {
-          // For direct calls, deduplicate by function
-          if (calledFunctions.insert(Callee).second) {
-            fanOut++;
-          }
+    for (const auto &[Callee, mask] : calleeMasks) {
+      for (uint64_t bits = mask; bits; bits &= bits - 1) {
+        fanOuts[countTrailingZeros(bits)]++;
+      }
+    }
+  }
+
+private:
+  // Paths in which V is tainted
+  uint64_t getTaintMask(const Value *V) const {
+    if (Taint.isUnconditional(V)) {
+      return ~uint64_t(0);
+    }
+    uint64_t mask = 0;
+    for (PHINode *Gate : Taint.getGates(V)) {
+      mask |= phiMasks.lookup(Gate);
+    }
+    return mask;
+  }
+
+  // Inside a chain, the previous block is the only predecessor and every
+  // path of the node takes the edge from it
+  void evaluatePhis(BasicBlock *ChainPred, BasicBlock *BB, uint64_t mask) {
+    SmallVector<std::pair<PHINode *, uint64_t>, 4> results;
+    for (PHINode &Phi : BB->phis()) {
+      if (Taint.getGates(&Phi).empty()) {
+        continue;
+      }
+      uint64_t tainted = 0;
+      for (unsigned i = 0; i < Phi.getNumIncomingValues(); ++i) {
+        BasicBlock *In = Phi.getIncomingBlock(i);
+        uint64_t edge = ChainPred ? (In == ChainPred ? mask : 0)
+                                  : edgeMasks.lookup({In, BB});
+        if (edge) {
+          tainted |= edge & getTaintMask(Phi.getIncomingValue(i));
         }
       }
+      results.push_back({&Phi, tainted});
+    }
+    for (const auto &[Phi, tainted] : results) {
+      phiMasks[Phi] = tainted;
     }
   }
 
-  return fanOut;
+  void countCall(Instruction *I, uint64_t mask,
+                 MutableArrayRef<unsigned> fanOuts) {
+    CallInst *Call = dyn_cast<CallInst>(I);
+    if (!Call)
+      return;
+    Function *Callee = Call->getCalledFunction();
+    if (Callee && Callee->isIntrinsic()) {
+      return;
+    }
+
+    uint64_t tainted = 0;
+    for (unsigned i = 0; i < Call->arg_size() && tainted != mask; ++i) {
+      tainted |= getTaintMask(Call->getArgOperand(i));
+    }
+    tainted &= mask;
+    if (!tainted) {
+      return;
+    }
+    if (Callee) {
+      calleeMasks[Callee] |= tainted;
+      return;
+    }
+    // Every occurrence of an indirect call counts
+    for (uint64_t bits = tainted; bits; bits &= bits - 1) {
+      fanOuts[countTrailingZeros(bits)]++;
+    }
+  }
+
+  const SparseTaint &Taint;
+  const CFGIndex &CFG;
+  ArrayRef<uint32_t> rpo;
+  std::vector<uint64_t> nodeMasks;
+  DenseMap<std::pair<BasicBlock *, BasicBlock *>, uint64_t> edgeMasks;
+  DenseMap<const PHINode *, uint64_t> phiMasks;
+  DenseMap<Function *, uint64_t> calleeMasks;
+};
+
+// Calculate fan-out for a single path
+unsigned calculatePathFanOut(const SparseTaint &Taint, PathView path) {
+  PathFanOut FanOut(Taint);
+  for (BasicBlock *BB : path) {
+    FanOut.enter(BB);
+  }
+  return FanOut.getFanOut();
 }
 
 } // anonymous namespace
@@ -163,6 +450,7 @@ unsigned calculatePathFanOut(const Path &path) {
 PreservedAnalyses PathBasedInterProcFanOutPass::run(Module &M,
                                                     ModuleAnalysisManager &AM) {
   size_t function_num = 0;
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
 
   for (Function &F : M) {
     function_num++;
@@ -173,16 +461,53 @@ PreservedAnalyses PathBasedInterProcFanOutPass::run(Module &M,
 
     errs() << "Analyzing function: " << F.getName() << "\n";
 
-    // Create path enumerator with reasonable limits
-    // Use smaller maxLoopIterations (1) for fan-out analysis to avoid explosion
-    PathEnumerator PE(F, 5000, 1);
+    // Count the paths first to decide how to cover them
+    PathCounter PC(F, FAM.getResult<LoopAnalysis>(F),
+                   Budget.maxLoopIterations, Budget.uniqueSuccessors,
+                   Budget.pruneCold);
+    EnumerationPlan Plan = EnumerationPlan::choose(PC, Budget.maxPaths,
+                                                   Budget.isBestFirst());
+    errs() << "  Enumeration mode: ";
+    Plan.print(errs());
+    errs() << "\n";
 
-    if (PE.getPathCount() == 0) {
+    if (Plan.mode == EnumerationPlan::Skipped) {
       errs() << "  No paths found (function may have no exits)\n\n";
       continue;
     }
 
-    const auto &paths = PE.getPaths();
+    auto &PEA = FAM.getResult<PathEnumeratorAnalysis>(F);
+    // Taint facts of the function, shared by every path below
+    SparseTaint Taint(F);
+
+    // Estimate over all paths from uniform random walks, each weighted by its
+    // inverse probability so that the mean is per path
+    auto printSampledEstimate = [&]() {
+      PathSampler Sampler(PEA.getCFG(Budget), Budget.maxLoopIterations);
+      SampleEstimator Estimate;
+      while (Estimate.getNumSamples() < NumSampledPaths && Sampler.next()) {
+        Estimate.add(calculatePathFanOut(Taint, Sampler.currentView()),
+                     -Sampler.getLogProbability());
+      }
+      errs() << "    Sampled estimate (" << Estimate.getNumSamples()
+             << " random paths):\n";
+      Estimate.print(errs(), "      ", "fan-out");
+    };
+
+    if (Plan.mode == EnumerationPlan::Sampled) {
+      errs() << "  Summary for " << F.getName() << ":\n";
+      printSampledEstimate();
+      errs() << "\n";
+      continue;
+    }
+
+    const PathEnumerator &PE = PEA.get(Budget, FAM);
+    const PathStore &Paths = PE.getPathStore();
+
+    if (Paths.empty()) {
+      errs() << "  No paths found (function may have no exits)\n\n";
+      continue;
+    }
 
     // Track statistics
     unsigned maxFanOut = 0;
@@ -190,17 +515,73 @@ PreservedAnalyses PathBasedInterProcFanOutPass::run(Module &M,
     size_t pathsAnalyzed = 0;
 
     // Limit detailed output for functions with many paths
-    bool printDetails = paths.size() <= 50;
+    bool printDetails = Paths.size() <= 50;
+
+    // Fan-out of every path. Unless each path is to be evaluated on its own,
+    // without cycles batches of paths are evaluated bit-parallel; otherwise
+    // one DFS over the enumeration tree, where consecutive paths share the
+    // prefix up to the branch the enumeration backtracked to, so only the
+    // blocks after it are left and entered.
+    const CFGIndex &CFG = *Paths.getCFG();
+    std::vector<uint32_t> rpo = CFG.getReversePostOrder();
+    std::vector<uint32_t> rpoNumber(CFG.size(), UINT32_MAX);
+    for (uint32_t i = 0; i < rpo.size(); ++i) {
+      rpoNumber[rpo[i]] = i;
+    }
+    bool acyclic = llvm::all_of(rpo, [&](uint32_t node) {
+      return llvm::all_of(CFG.successors(node), [&](uint32_t succ) {
+        return rpoNumber[succ] > rpoNumber[node];
+      });
+    });
+
+    std::vector<unsigned> fanOuts(Paths.size());
+    if (PerPath) {
+      for (size_t p = 0; p < Paths.size(); ++p) {
+        fanOuts[p] = calculatePathFanOut(Taint, Paths[p]);
+      }
+    } else if (acyclic) {
+      BatchFanOut Batch(Taint, CFG, rpo);
+      SmallVector<ArrayRef<uint32_t>, BatchFanOut::Width> batch;
+      for (size_t first = 0; first < Paths.size();
+           first += BatchFanOut::Width) {
+        batch.clear();
+        size_t end = std::min(Paths.size(), first + BatchFanOut::Width);
+        for (size_t p = first; p < end; ++p) {
+          batch.push_back(Paths[p].getBlockIndices());
+        }
+        Batch.run(batch, MutableArrayRef<unsigned>(fanOuts).slice(
+                             first, end - first));
+      }
+    } else {
+      PathFanOut FanOut(Taint);
+      ArrayRef<uint32_t> previous;
+      for (size_t p = 0; p < Paths.size(); ++p) {
+        ArrayRef<uint32_t> nodes = Paths[p].getBlockIndices();
+        size_t shared = 0;
+        size_t limit = std::min(previous.size(), nodes.size());
+        while (shared < limit && previous[shared] == nodes[shared]) {
+          shared++;
+        }
+        while (FanOut.getDepth() > shared) {
+          FanOut.leave();
+        }
+        for (size_t depth = shared; depth < nodes.size(); ++depth) {
+          FanOut.enter(CFG.getChain(nodes[depth]));
+        }
+        previous = nodes;
+        fanOuts[p] = FanOut.getFanOut();
+      }
+    }
 
-    for (size_t i = 0; i < paths.size(); ++i) {
-      unsigned fanOut = calculatePathFanOut(paths[i]);
+    for (PathView path : Paths) {
+      unsigned fanOut = fanOuts[pathsAnalyzed];
 
       maxFanOut = std::max(maxFanOut, fanOut);
       totalFanOut += fanOut;
       pathsAnalyzed++;
 
       if (printDetails) {
-        errs() << "  Path " << (i + 1) << " (length: " << paths[i].size()
+        errs() << "  Path " << pathsAnalyzed << " (length: " << path.size()
                << " blocks): FanOut = " << fanOut << "\n";
       }
     }
@@ -217,7 +598,10 @@ PreservedAnalyses PathBasedInterProcFanOutPass::run(Module &M,
     }
 
     if (PE.hasReachedLimit()) {
-      errs() << "    Warning: Path limit reached, analysis incomplete\n";
+      errs() << "    Warning: ";
+      Budget.printLimitReached(errs(), PE.getLimitHit());
+      errs() << ", analysis incomplete\n";
+      printSampledEstimate();
     }
 
     errs() << "\n";
@@ -1,6 +1,10 @@
 #include "PathBasedMaxPath.h"
+#include "PathCounter.h"
 #include "PathEnumerator.h"
+#include "PathEnumeratorAnalysis.h"
+#include "PathSampler.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemorySSA.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
@@ -13,12 +17,15 @@
 using namespace llvm;
 using namespace hepf;
 
+// Random paths drawn when exhaustive enumeration is not possible
+static constexpr size_t NumSampledPaths = 1000;
+
 namespace {
 
 // Build a path-aware dependence graph
 class PathDependenceGraph {
 public:
-  PathDependenceGraph(const Path &path, DependenceInfo *DI) : DI(DI) {
+  PathDependenceGraph(PathView path, DependenceInfo *DI) : DI(DI) {
     collectInstructions(path);
     buildDependencies();
   }
@@ -42,7 +49,7 @@ private:
   // -----------------------------------------------------------
   // Helper Functions
   // -----------------------------------------------------------
-  void collectInstructions(const Path &path) {
+  void collectInstructions(PathView path) {
     for (BasicBlock *BB : path) {
       for (Instruction &I : *BB) {
         instructions.push_back(&I);
@@ -192,6 +199,7 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
   errs() << "=== Path Based Max Path Pass ===\n\n";
 
   size_t function_num = 0;
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
 
   for (Function &F : M) {
     function_num++;
@@ -202,19 +210,23 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
 
     errs() << "Analyzing function: " << F.getName() << "\n";
 
-    // Create path enumerator with reasonable limits
-    PathEnumerator PE(F, 5000, 1);
+    // Count the paths first to decide how to cover them
+    PathCounter PC(F, FAM.getResult<LoopAnalysis>(F),
+                   Budget.maxLoopIterations, Budget.uniqueSuccessors,
+                   Budget.pruneCold);
+    EnumerationPlan Plan = EnumerationPlan::choose(PC, Budget.maxPaths,
+                                                   Budget.isBestFirst());
+    errs() << "  Enumeration mode: ";
+    Plan.print(errs());
+    errs() << "\n";
 
-    if (PE.getPathCount() == 0) {
+    if (Plan.mode == EnumerationPlan::Skipped) {
       errs() << "  No paths found (function may have no exits)\n\n";
       continue;
     }
 
     // Try to get dependence analysis results
     DependenceInfo *DI = nullptr;
-    auto &FAM =
-        AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
-
     try {
       DI = &FAM.getResult<DependenceAnalysis>(F);
     } catch (...) {
@@ -222,7 +234,38 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
              << "(DependenceAnalysis not available)\n";
     }
 
-    const auto &paths = PE.getPaths();
+    auto &PEA = FAM.getResult<PathEnumeratorAnalysis>(F);
+
+    // Estimate over all paths from uniform random walks, each weighted by its
+    // inverse probability so that the mean is per path
+    auto printSampledEstimate = [&]() {
+      PathSampler Sampler(PEA.getCFG(Budget), Budget.maxLoopIterations);
+      SampleEstimator Estimate;
+      while (Estimate.getNumSamples() < NumSampledPaths && Sampler.next()) {
+        PathDependenceGraph PDG(Sampler.currentView(), DI);
+        Estimate.add(PDG.getLongestPath(), -Sampler.getLogProbability());
+      }
+      errs() << "    Sampled estimate (" << Estimate.getNumSamples()
+             << " random paths):\n";
+      Estimate.print(errs(), "      ", "critical path length",
+                     " instructions");
+    };
+
+    if (Plan.mode == EnumerationPlan::Sampled) {
+      errs() << "  Summary for " << F.getName() << ":\n";
+      errs() << "    Total functions analyzed: " << function_num << "\n";
+      printSampledEstimate();
+      errs() << "\n";
+      continue;
+    }
+
+    const PathEnumerator &PE = PEA.get(Budget, FAM);
+    const PathStore &Paths = PE.getPathStore();
+
+    if (Paths.empty()) {
+      errs() << "  No paths found (function may have no exits)\n\n";
+      continue;
+    }
 
     // Track statistics
     unsigned maxPathLength = 0;
@@ -230,11 +273,11 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
     size_t pathsAnalyzed = 0;
 
     // Limit detailed output for functions with many paths
-    bool printDetails = paths.size() <= 50;
+    bool printDetails = Paths.size() <= 50;
 
-    for (size_t i = 0; i < paths.size(); ++i) {
+    for (PathView path : Paths) {
       // Build dependence graph for this path
-      PathDependenceGraph PDG(paths[i], DI);
+      PathDependenceGraph PDG(path, DI);
       unsigned pathLength = PDG.getLongestPath();
 
       maxPathLength = std::max(maxPathLength, pathLength);
@@ -242,7 +285,7 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
       pathsAnalyzed++;
 
       if (printDetails) {
-        errs() << "  Path " << (i + 1) << " (BB count: " << paths[i].size()
+        errs() << "  Path " << pathsAnalyzed << " (BB count: " << path.size()
                << ", critical path: " << pathLength << " instructions)\n";
       }
     }
@@ -261,7 +304,10 @@ PreservedAnalyses PathBasedMaxPathPass::run(Module &M,
     }
 
     if (PE.hasReachedLimit()) {
-      errs() << "    Warning: Path limit reached, analysis incomplete\n";
+      errs() << "    Warning: ";
+      Budget.printLimitReached(errs(), PE.getLimitHit());
+      errs() << ", analysis incomplete\n";
+      printSampledEstimate();
     }
 
     errs() << "\n";
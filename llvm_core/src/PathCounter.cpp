@@ -0,0 +1,225 @@
+#include "PathCounter.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace hepf;
+
+static constexpr uint32_t Unreachable = UINT32_MAX;
+
+PathCounter::PathCounter(Function &F, LoopInfo &LI, size_t maxLoopIterations,
+                         bool uniqueSuccessors, bool pruneCold)
+    : CFG(F, uniqueSuccessors, /*superblocks=*/false, pruneCold), LI(LI),
+      maxLoopIterations(maxLoopIterations), numPaths(0), numPrunedPaths(0),
+      pruning(pruneCold), overflowed(false), exact(true), upperBound(true) {
+  if (CFG.empty())
+    return;
+
+  // Reverse post-order of the reachable blocks: a topological order of the
+  // CFG without back edges when the CFG is reducible
+  std::vector<uint8_t> visited(CFG.size(), 0);
+  std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, CFG.edgeBegin(0)}};
+  visited[0] = 1;
+  while (!stack.empty()) {
+    auto &[block, edge] = stack.back();
+    if (edge == CFG.edgeEnd(block)) {
+      rpo.push_back(block);
+      stack.pop_back();
+      continue;
+    }
+    uint32_t succ = CFG.getEdgeTarget(edge++);
+    if (!visited[succ]) {
+      visited[succ] = 1;
+      stack.emplace_back(succ, CFG.edgeBegin(succ));
+    }
+  }
+  std::reverse(rpo.begin(), rpo.end());
+  rpoNumber.assign(CFG.size(), Unreachable);
+  for (uint32_t i = 0; i < rpo.size(); ++i)
+    rpoNumber[rpo[i]] = i;
+
+  // Innermost loops first
+  SmallVector<Loop *, 8> loops = LI.getLoopsInPreorder();
+  for (Loop *L : llvm::reverse(loops)) {
+    if (L->getLoopDepth() > 1)
+      exact = false;
+    Summary S = summarize(L);
+    expandIterations(S);
+    loopSummaries[L] = std::move(S);
+  }
+
+  // The function body has no header to return to and nowhere to exit to
+  numPaths = summarize(nullptr).terminating;
+
+  // Pruned paths are the difference to the unpruned count
+  if (pruneCold && CFG.getNumPrunedEdges()) {
+    PathCounter All(F, LI, maxLoopIterations, uniqueSuccessors);
+    if (All.getNumPaths() > numPaths)
+      numPrunedPaths = All.getNumPaths() - numPaths;
+  }
+}
+
+uint64_t PathCounter::add(uint64_t a, uint64_t b) {
+  uint64_t result;
+  if (__builtin_add_overflow(a, b, &result)) {
+    overflowed = true;
+    return UINT64_MAX;
+  }
+  return result;
+}
+
+uint64_t PathCounter::mul(uint64_t a, uint64_t b) {
+  uint64_t result;
+  if (__builtin_mul_overflow(a, b, &result)) {
+    overflowed = true;
+    return UINT64_MAX;
+  }
+  return result;
+}
+
+PathCounter::Summary PathCounter::summarize(Loop *L) {
+  Summary S;
+
+  // Blocks of the scope in topological order
+  std::vector<uint32_t> blocks;
+  if (L) {
+    for (BasicBlock *BB : L->blocks())
+      blocks.push_back(CFG.getIndex(BB));
+    llvm::sort(blocks, [&](uint32_t a, uint32_t b) {
+      return rpoNumber[a] < rpoNumber[b];
+    });
+  } else {
+    blocks = rpo;
+  }
+
+  uint32_t header = L ? CFG.getIndex(L->getHeader()) : 0;
+  DenseMap<uint32_t, uint64_t> ways;
+  ways[header] = 1;
+
+  // Route 'count' paths from 'from' to the block 'to'
+  auto flow = [&](uint32_t from, uint32_t to, uint64_t count) {
+    BasicBlock *To = CFG.getBlock(to);
+    if (L && to == header) {
+      S.cycles = add(S.cycles, count);
+    } else if (L && !L->contains(To)) {
+      auto It = llvm::find_if(S.exits, [&](const auto &E) {
+        return E.first == to;
+      });
+      if (It == S.exits.end())
+        S.exits.emplace_back(to, count);
+      else
+        It->second = add(It->second, count);
+    } else if (rpoNumber[to] <= rpoNumber[from]) {
+      // A retreating edge that is not a loop back edge: irreducible CFG
+      exact = upperBound = false;
+    } else {
+      ways[to] = add(ways[to], count);
+    }
+  };
+
+  for (uint32_t block : blocks) {
+    uint64_t count = ways.lookup(block);
+    if (count == 0)
+      continue;
+
+    BasicBlock *BB = CFG.getBlock(block);
+    Loop *Inner = LI.getLoopFor(BB);
+    if (Inner != L) {
+      // The block belongs to a nested loop; paths can only enter it through
+      // the header of the outermost such loop
+      while (Inner->getParentLoop() != L)
+        Inner = Inner->getParentLoop();
+      if (Inner->getHeader() != BB) {
+        exact = upperBound = false;
+        continue;
+      }
+
+      const Summary &IS = loopSummaries[Inner];
+      S.terminating = add(S.terminating, mul(count, IS.terminating));
+      for (const auto &[target, exitCount] : IS.exits)
+        flow(block, target, mul(count, exitCount));
+      continue;
+    }
+
+    if (CFG.isExit(block)) {
+      S.terminating = add(S.terminating, count);
+      continue;
+    }
+    for (uint32_t succ : CFG.successors(block))
+      flow(block, succ, count);
+  }
+  return S;
+}
+
+void PathCounter::expandIterations(Summary &S) {
+  // Each path out of the loop runs 0..maxLoopIterations full cycles first
+  uint64_t multiplier = 1;
+  if (S.cycles == 1) {
+    multiplier = add(maxLoopIterations, 1);
+  } else if (S.cycles > 1) {
+    uint64_t power = 1;
+    for (size_t i = 1; i <= maxLoopIterations && multiplier != UINT64_MAX;
+         ++i) {
+      power = mul(power, S.cycles);
+      multiplier = add(multiplier, power);
+    }
+  }
+
+  S.terminating = mul(S.terminating, multiplier);
+  for (auto &E : S.exits)
+    E.second = mul(E.second, multiplier);
+}
+
+// -----------------------------------------------------------
+// EnumerationPlan
+// -----------------------------------------------------------
+EnumerationPlan EnumerationPlan::choose(const PathCounter &counter,
+                                        size_t maxPaths, bool bestFirst) {
+  // Without a reliable bound, enumerate and let the path limit decide
+  if (!counter.isUpperBound())
+    return {Exhaustive, counter, maxPaths};
+  if (counter.getNumPaths() == 0)
+    return {Skipped, counter, maxPaths};
+  if (counter.getNumPaths() <= maxPaths)
+    return {Exhaustive, counter, maxPaths};
+  return {bestFirst ? BestFirst : Sampled, counter, maxPaths};
+}
+
+void EnumerationPlan::print(raw_ostream &OS) const {
+  switch (mode) {
+  case Exhaustive:
+    OS << "exhaustive";
+    break;
+  case Sampled:
+    OS << "sampled";
+    break;
+  case Skipped:
+    OS << "skipped";
+    break;
+  case BestFirst:
+    OS << "best-first";
+    break;
+  case Summarized:
+    OS << "DP only, paths not listed";
+    break;
+  case Truncated:
+    OS << "first " << maxPaths << " paths";
+    break;
+  }
+
+  OS << " (";
+  if (counter.hasOverflowed())
+    OS << "at least ";
+  else if (!counter.isUpperBound())
+    OS << "about ";
+  else if (!counter.isExact())
+    OS << "at most ";
+  OS << counter.getNumPaths() << " paths";
+  if (mode == Sampled || mode == BestFirst || mode == Summarized ||
+      mode == Truncated)
+    OS << " > limit " << maxPaths;
+  if (counter.isPruning())
+    OS << ", " << counter.getNumPrunedPaths() << " pruned";
+  if (!counter.isUpperBound())
+    OS << ", irreducible CFG";
+  OS << ")";
+}
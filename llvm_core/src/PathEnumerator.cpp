@@ -1,95 +1,260 @@
 #include "PathEnumerator.h"
-#include "llvm/IR/CFG.h"
+#include "BestFirstPathEnumerator.h"
+#include "ParallelPathEnumerator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 using namespace hepf;
 
-PathEnumerator::PathEnumerator(Function &F, size_t maxPaths,
-                               size_t maxLoopIterations)
-    : F(F), maxPaths(maxPaths), maxLoopIterations(maxLoopIterations),
-      reachedLimit(false) {
+// -----------------------------------------------------------
+// PathStream
+// -----------------------------------------------------------
+PathStream::PathStream(Function &F, size_t maxPaths, size_t maxLoopIterations)
+    : PathStream(std::make_shared<CFGIndex>(F), maxPaths, maxLoopIterations) {}
 
-  errs() << "=== Path Enumerator ===\n\n";
+PathStream::PathStream(std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+                       size_t maxLoopIterations)
+    : CFG(std::move(CFG)), maxPaths(maxPaths),
+      maxLoopIterations(maxLoopIterations), currentPathValid(false),
+      visitCount(this->CFG->size(), 0), pathCount(0), sharedPrefix(0), started(false),
+      finished(this->CFG->empty()), reachedLimit(false), warnOnLimit(false),
+      stepsUntilCheck(DeadlineCheckInterval), expired(false) {}
 
-  // Sanity check: function must have an entry block
-  if (F.empty()) {
-    errs() << "Warning: Function " << F.getName() << " is empty\n";
-    return;
+PathStream::PathStream(std::shared_ptr<const CFGIndex> CFG, size_t maxPaths,
+                       size_t maxLoopIterations, ArrayRef<uint32_t> prefix)
+    : PathStream(std::move(CFG), maxPaths, maxLoopIterations) {
+  // Every prefix block but the last is already fully explored
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    uint32_t block = prefix[i];
+    visitCount[block]++;
+    pathBlocks.push_back(block);
+    nextEdges.push_back(i + 1 < prefix.size() ? this->CFG->edgeEnd(block)
+                                              : this->CFG->edgeBegin(block));
   }
+}
 
-  // Start path enumeration from entry block
-  std::vector<BasicBlock *> currentPath;
-  std::unordered_map<BasicBlock *, size_t> visitCount;
+bool PathStream::enter(uint32_t block) {
+  // If we've exceeded the loop iteration limit for this block, stop exploring
+  if (visitCount[block] > maxLoopIterations) {
+    return false;
+  }
 
-  findAllPaths(&F.getEntryBlock(), currentPath, visitCount);
+  // Add block to path and increment visit count
+  visitCount[block]++;
+  pathBlocks.push_back(block);
+  nextEdges.push_back(CFG->edgeBegin(block));
+  return true;
+}
 
-  if (reachedLimit) {
-    errs() << "Warning: Path enumeration limit (" << maxPaths
-           << ") reached for function " << F.getName() << "\n";
-  }
+void PathStream::leave() {
+  // Backtrack: remove the block from the path and decrement its visit count
+  visitCount[pathBlocks.back()]--;
+  pathBlocks.pop_back();
+  nextEdges.pop_back();
 }
 
-const std::vector<Path> &PathEnumerator::getPaths() const { return paths; }
+void PathStream::setDeadline(std::chrono::steady_clock::time_point deadline) {
+  this->deadline = deadline;
+}
 
-bool PathEnumerator::isExitBlock(BasicBlock *BB) const {
-  // Exit blocks have no successors
-  return succ_begin(BB) == succ_end(BB);
+bool PathStream::checkDeadline() {
+  stepsUntilCheck = DeadlineCheckInterval;
+  if (std::chrono::steady_clock::now() >= *deadline)
+    expired = true;
+  return expired;
 }
 
-void PathEnumerator::findAllPaths(
-    BasicBlock *current, std::vector<BasicBlock *> &currentPath,
-    std::unordered_map<BasicBlock *, size_t> &visitCount) {
-  // Check if we've reached the path limit
-  if (paths.size() >= maxPaths) {
-    reachedLimit = true;
-    return;
+const Path &PathStream::current() const {
+  if (!currentPathValid) {
+    currentPath.assign(currentView().begin(), currentView().end());
+    currentPathValid = true;
+  }
+  return currentPath;
+}
+
+bool PathStream::next() {
+  if (finished) {
+    return false;
   }
+  currentPathValid = false;
 
-  // Check how many times we've visited this block in the current path
-  size_t currentVisits = visitCount[current];
+  if (!started) {
+    started = true;
 
-  // If we've exceeded the loop iteration limit for this block, stop exploring
-  if (currentVisits > maxLoopIterations) {
-    return;
+    if (pathBlocks.empty()) {
+      enter(0);
+    }
+    if (CFG->isExit(pathBlocks.back())) {
+      // A path beyond the limit only tells us that the limit was reached
+      if (pathCount >= maxPaths) {
+        reachedLimit = true;
+      } else {
+        pathCount++;
+        return true;
+      }
+    }
+  } else if (!pathBlocks.empty()) {
+    // The previously returned path ended at this exit block
+    leave();
   }
 
-  // Add current block to path and increment visit count
-  currentPath.push_back(current);
-  visitCount[current]++;
+  // Blocks below this depth were never popped since the previous path
+  size_t lowWater = pathCount == 0 ? 0 : pathBlocks.size();
 
-  // If this is an exit block, save the complete path
-  if (isExitBlock(current)) {
-    paths.push_back(currentPath);
-  } else {
-    // Explore all successors
-    bool hasSuccessors = false;
-    for (BasicBlock *succ : successors(current)) {
-      hasSuccessors = true;
+  while (!reachedLimit && !pathBlocks.empty()) {
+    if (deadline && --stepsUntilCheck == 0 && checkDeadline())
+      break;
 
-      // Early exit if limit reached
-      if (paths.size() >= maxPaths) {
+    uint32_t &nextEdge = nextEdges.back();
+    if (nextEdge == CFG->edgeEnd(pathBlocks.back())) {
+      leave();
+      lowWater = std::min(lowWater, pathBlocks.size());
+      continue;
+    }
+
+    uint32_t succ = CFG->getEdgeTarget(nextEdge++);
+    if (enter(succ) && CFG->isExit(succ)) {
+      // The limit is reached only if more than maxPaths paths exist, so the
+      // answer does not depend on how the enumeration is split into tasks
+      if (pathCount >= maxPaths) {
         reachedLimit = true;
         break;
       }
-
-      findAllPaths(succ, currentPath, visitCount);
+      pathCount++;
+      sharedPrefix = lowWater;
+      return true;
     }
+  }
+
+  finished = true;
+  if (reachedLimit && warnOnLimit) {
+    Function *F = CFG->getBlock(0)->getParent();
+    errs() << "Warning: Path enumeration limit (" << maxPaths
+           << ") reached for function " << F->getName() << "\n";
+  }
+  return false;
+}
+
+// -----------------------------------------------------------
+// PathEnumerator
+// -----------------------------------------------------------
+PathEnumerator::PathEnumerator(Function &F, size_t maxPaths,
+                               size_t maxLoopIterations)
+    : PathEnumerator(F, std::make_shared<CFGIndex>(F), maxPaths,
+                     maxLoopIterations) {}
+
+PathEnumerator::PathEnumerator(Function &F,
+                               std::shared_ptr<const CFGIndex> CFG,
+                               size_t maxPaths, size_t maxLoopIterations)
+    : PathEnumerator(F, std::move(CFG),
+                     EnumerationBudget{maxPaths, maxLoopIterations}) {}
+
+PathEnumerator::PathEnumerator(Function &F,
+                               std::shared_ptr<const CFGIndex> CFG,
+                               const EnumerationBudget &budget)
+    : F(F), CFG(std::move(CFG)), budget(budget),
+      numThreads(budget.numThreads), store(this->CFG), drained(false), materialized(false),
+      limitHit(BudgetLimit::None), coveredProbability(0.0) {
+
+  errs() << "=== Path Enumerator ===\n\n";
+
+  // Sanity check: function must have an entry block
+  if (F.empty()) {
+    errs() << "Warning: Function " << F.getName() << " is empty\n";
+  }
+}
+
+PathStream PathEnumerator::stream() const {
+  PathStream S(CFG, budget.maxPaths, budget.maxLoopIterations);
+  S.setWarnOnLimit(true);
+  if (budget.timeMs)
+    S.setDeadline(std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(budget.timeMs));
+  return S;
+}
+
+void PathEnumerator::drain() const {
+  if (drained) {
+    return;
+  }
 
-    // Handle unreachable blocks (no successors but not a proper exit)
-    if (!hasSuccessors && !isExitBlock(current)) {
-      // This could be a block ending in unreachable or similar
-      // Treat it as a complete path
-      paths.push_back(currentPath);
+  drained = true;
+  if (budget.isBestFirst()) {
+    // Best-first order is global, so it does not split into DFS subtrees
+    BestFirstPathEnumerator BFE(CFG, budget, edgeProbabilities);
+    store = BFE.run();
+    limitHit = BFE.getLimitHit();
+    coveredProbability = BFE.getCoveredProbability();
+    if (limitHit == BudgetLimit::Paths) {
+      errs() << "Warning: Path enumeration limit (" << budget.maxPaths
+             << ") reached for function " << F.getName() << "\n";
     }
+  } else if (numThreads != 1) {
+    ParallelPathEnumerator PPE(CFG, budget, numThreads);
+    store = PPE.run();
+    store.shrinkToFit();
+    limitHit = PPE.getLimitHit();
+    if (limitHit == BudgetLimit::Paths) {
+      errs() << "Warning: Path enumeration limit (" << budget.maxPaths
+             << ") reached for function " << F.getName() << "\n";
+    }
+  } else {
+    PathStream S = stream();
+    while (S.next()) {
+      store.append(S.currentIndices());
+      if (budget.memBytes && store.getMemoryUsage() > budget.memBytes) {
+        limitHit = BudgetLimit::Memory;
+        break;
+      }
+    }
+    store.shrinkToFit();
+    if (S.hasReachedLimit())
+      limitHit = BudgetLimit::Paths;
+    else if (S.hasExpired())
+      limitHit = BudgetLimit::Time;
   }
 
-  // Backtrack: remove current block from path and decrement visit count
-  currentPath.pop_back();
-  visitCount[current]--;
+  if (limitHit == BudgetLimit::Time || limitHit == BudgetLimit::Memory) {
+    errs() << "Warning: ";
+    budget.printLimitReached(errs(), limitHit);
+    errs() << " for function " << F.getName() << " after " << store.size()
+           << " paths\n";
+  }
+}
+
+const PathStore &PathEnumerator::getPathStore() const {
+  drain();
+  return store;
+}
 
-  // Clean up the map if count reaches zero (optional optimization)
-  if (visitCount[current] == 0) {
-    visitCount.erase(current);
+const std::vector<Path> &PathEnumerator::getPaths() const {
+  drain();
+  if (!materialized) {
+    materialized = true;
+    paths.reserve(store.size());
+    for (PathView path : store)
+      paths.push_back(path.toPath());
   }
+  return paths;
+}
+
+bool PathEnumerator::hasReachedLimit() const {
+  drain();
+  return limitHit != BudgetLimit::None;
+}
+
+BudgetLimit PathEnumerator::getLimitHit() const {
+  drain();
+  return limitHit;
+}
+
+double PathEnumerator::getCoveredProbability() const {
+  drain();
+  return coveredProbability;
+}
+
+size_t PathEnumerator::getPathCount() const {
+  drain();
+  return store.size();
 }
@@ -0,0 +1,83 @@
+#include "PathEnumeratorAnalysis.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+
+using namespace llvm;
+using namespace hepf;
+
+AnalysisKey PathEnumeratorAnalysis::Key;
+
+PathEnumeratorAnalysis::Result::Result(Function &F)
+    : F(&F) {
+  CFGs[0] = std::make_shared<CFGIndex>(F);
+}
+
+const PathEnumerator &
+PathEnumeratorAnalysis::Result::get(size_t maxPaths, size_t maxLoopIterations) {
+  return get(EnumerationBudget{maxPaths, maxLoopIterations});
+}
+
+const PathEnumerator &
+PathEnumeratorAnalysis::Result::get(const EnumerationBudget &budget,
+                                    const BranchProbabilityInfo *BPI) {
+  std::unique_ptr<PathEnumerator> &PE = enumerations[budget];
+  if (!PE) {
+    const std::shared_ptr<const CFGIndex> &CFG =
+        getCFG(budget);
+    PE = std::make_unique<PathEnumerator>(*F, CFG, budget);
+    if (budget.isBestFirst() && BPI)
+      PE->setEdgeProbabilities(CFG->getEdgeProbabilities(*BPI));
+  }
+  return *PE;
+}
+
+const PathEnumerator &
+PathEnumeratorAnalysis::Result::get(const EnumerationBudget &budget,
+                                    FunctionAnalysisManager &FAM) {
+  if (!budget.isBestFirst())
+    return get(budget);
+  return get(budget, &FAM.getResult<BranchProbabilityAnalysis>(*F));
+}
+
+const std::shared_ptr<const CFGIndex> &
+PathEnumeratorAnalysis::Result::getCFG(bool uniqueSuccessors, bool superblocks,
+                                       bool pruneCold) {
+  std::shared_ptr<const CFGIndex> &CFG =
+      CFGs[uniqueSuccessors + 2 * superblocks + 4 * pruneCold];
+  if (!CFG)
+    CFG = std::make_shared<CFGIndex>(*F, uniqueSuccessors, superblocks,
+                                     pruneCold);
+  return CFG;
+}
+
+const std::shared_ptr<const CFGIndex> &
+PathEnumeratorAnalysis::Result::getCFG(const EnumerationBudget &budget) {
+  return getCFG(budget.uniqueSuccessors, budget.superblocks, budget.pruneCold);
+}
+
+bool PathEnumeratorAnalysis::Result::invalidate(
+    Function &, const PreservedAnalyses &PA,
+    FunctionAnalysisManager::Invalidator &) {
+  auto PAC = PA.getChecker<PathEnumeratorAnalysis>();
+  if (PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>())
+    return false;
+  if (!PAC.preservedSet<CFGAnalyses>())
+    return true;
+
+  // The CFG is unchanged, but which of its edges prune-cold removes also
+  // depends on the calls in the blocks (noreturn, cold) and on !prof, which
+  // a pass preserving the CFG may still change
+  for (auto It = enumerations.begin(); It != enumerations.end();) {
+    if (It->first.pruneCold)
+      It = enumerations.erase(It);
+    else
+      ++It;
+  }
+  for (unsigned mode = 4; mode < 8; ++mode)
+    CFGs[mode].reset();
+  return false;
+}
+
+PathEnumeratorAnalysis::Result
+PathEnumeratorAnalysis::run(Function &F, FunctionAnalysisManager &) {
+  return Result(F);
+}
@@ -1,14 +1,96 @@
 #include "PathEnumeratorPass.h"
+#include "PathAlgebra.h"
 #include "PathEnumerator.h"
+#include "PathEnumeratorAnalysis.h"
+#include "PathCounter.h"
+#include "PathExpression.h"
+#include "PathNumbering.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/IR/Function.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <cmath>
 
 using namespace llvm;
 
 namespace hepf {
 
-PreservedAnalyses PathEnumeratorPass::run(Module &M, ModuleAnalysisManager &) {
+namespace {
+
+// Path count over a path expression, whose edges stand for all parallel
+// successor slots: without unique successors every slot is a path of its
+// own, as in the enumeration
+struct SlotCountAlgebra : PathCountAlgebra {
+  bool uniqueSuccessors;
+
+  explicit SlotCountAlgebra(bool uniqueSuccessors)
+      : uniqueSuccessors(uniqueSuccessors) {}
+  Value edge(BasicBlock *Src, BasicBlock *Dst) const {
+    if (uniqueSuccessors)
+      return 1;
+    return llvm::count(successors(Src), Dst);
+  }
+};
+
+// File of a function's serialized paths in a paths-out or paths-in
+// directory
+std::string getPathsFile(StringRef Dir, const Function &F) {
+  SmallString<128> File(Dir);
+  sys::path::append(File, F.getName() + ".paths");
+  return std::string(File);
+}
+
+void writePaths(StringRef File, const PathStore &Paths) {
+  SmallString<1024> Data;
+  raw_svector_ostream DataOS(Data);
+  Paths.serialize(DataOS);
+
+  std::error_code EC;
+  raw_fd_ostream OS(File, EC, sys::fs::OF_None);
+  if (EC) {
+    errs() << "  Paths not written to " << File << ": " << EC.message()
+           << "\n";
+    return;
+  }
+  OS << Data;
+  errs() << "  Paths written to " << File << " (" << Data.size()
+         << " bytes)\n";
+}
+
+// Reads back paths written by writePaths and compares them, path by path,
+// with the enumeration they should reproduce
+void comparePaths(StringRef File, const PathStore &Paths) {
+  errs() << "  Stored paths in " << File << ": ";
+  auto Buffer = MemoryBuffer::getFile(File);
+  if (!Buffer) {
+    errs() << "unreadable (" << Buffer.getError().message() << ")\n";
+    return;
+  }
+  std::optional<PathStore> Stored =
+      PathStore::deserialize((*Buffer)->getBuffer(), Paths.getCFG());
+  if (!Stored) {
+    errs() << "malformed or for another CFG\n";
+    return;
+  }
+  bool same = Stored->size() == Paths.size();
+  for (size_t i = 0; same && i < Paths.size(); ++i)
+    same = llvm::equal((*Stored)[i].getBlockIndices(),
+                       Paths[i].getBlockIndices());
+  errs() << Stored->size()
+         << (same ? ", same as enumerated" : ", different from enumerated")
+         << "\n";
+}
+
+} // anonymous namespace
+
+PreservedAnalyses PathEnumeratorPass::run(Module &M,
+                                          ModuleAnalysisManager &AM) {
   errs() << "=== Path Enumerator Pass ===\n\n";
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
 
   for (auto &F : M) {
     // Skip declarations and intrinsics
@@ -24,34 +106,157 @@ PreservedAnalyses PathEnumeratorPass::run(Module &M, ModuleAnalysisManager &) {
 
     errs() << "Analyzing function: " << F.getName() << "\n";
 
-    // Create path enumerator
-    // Parameters: maxPaths = 10000, maxLoopIterations = 2
-    // This will enumerate paths with loops traversed 0, 1, or 2 times
-    PathEnumerator PE(F, MaxPaths, MaxLoopIterations);
+    // Count first, so that the size of the enumeration is known up front
+    PathCounter PC(F, FAM.getResult<LoopAnalysis>(F),
+                   Budget.maxLoopIterations, Budget.uniqueSuccessors,
+                   Budget.pruneCold);
+    errs() << "  Enumeration mode: ";
+    // Over the limit, the pass lists the first maxPaths paths
+    EnumerationPlan::choose(PC, Budget.maxPaths, Budget.isBestFirst())
+        .truncating()
+        .print(errs());
+    errs() << "\n";
+
+    // Get the path enumeration (shared with other passes using the same
+    // limits). With maxLoopIterations = 2, loops are traversed 0, 1, or 2
+    // times.
+    const PathEnumerator &PE =
+        FAM.getResult<PathEnumeratorAnalysis>(F).get(Budget, FAM);
 
-    // Report results
-    errs() << "  Paths found: " << PE.getPathCount();
+    // Report results (getPathStore() drains the enumeration on first use)
+    const PathStore &paths = PE.getPathStore();
+    errs() << "  Paths found: " << paths.size();
 
-    if (PE.hasReachedLimit()) {
+    if (PE.getLimitHit() == BudgetLimit::Paths) {
       errs() << " (LIMIT REACHED - incomplete enumeration)";
+    } else if (PE.hasReachedLimit()) {
+      errs() << " (";
+      Budget.printLimitReached(errs(), PE.getLimitHit());
+      errs() << " - incomplete enumeration)";
     }
 
+    // Paths over merged switch edges each stand for several paths that
+    // differ only in which case they take
+    if (Budget.uniqueSuccessors) {
+      uint64_t represented = 0;
+      for (PathView path : paths) {
+        uint64_t multiplicity =
+            PE.getCFG()->getPathMultiplicity(path.getBlockIndices());
+        if (__builtin_add_overflow(represented, multiplicity, &represented))
+          represented = UINT64_MAX;
+      }
+      errs() << " (" << represented << " with duplicate successors)";
+    }
+
+    errs() << "\n";
+
+    // Serialized paths, one file per function
+    if (!PathsOut.empty())
+      writePaths(getPathsFile(PathsOut, F), paths);
+    if (!PathsIn.empty())
+      comparePaths(getPathsFile(PathsIn, F), paths);
+
+    // Paths into cold or noreturn code were never walked; say how many
+    if (Budget.pruneCold) {
+      errs() << "  Pruned paths (cold or noreturn): "
+             << PC.getNumPrunedPaths() << " at "
+             << PE.getCFG()->getNumPrunedEdges() << " edges\n";
+    }
+
+    // Paths were enumerated over contracted straight-line chains
+    if (Budget.superblocks) {
+      errs() << "  Superblocks: " << PE.getCFG()->size() << " nodes for "
+             << F.size() << " blocks\n";
+    }
+
+    // Best-first paths come out most probable first, up to the coverage
+    // target
+    if (Budget.isBestFirst()) {
+      errs() << "  Probability covered: "
+             << format("%.4f", PE.getCoveredProbability()) << " (target "
+             << format("%g", Budget.coverage) << ")\n";
+    }
+
+    // Ball-Larus numbering counts the acyclic paths over the CFG of the
+    // enumeration without materializing them, so the exact total is known
+    // even when the limit above was hit
+    PathNumbering PN(PE.getCFG());
+    errs() << "  Acyclic paths (Ball-Larus): ";
+    if (PN.hasOverflowed())
+      errs() << "more than " << PN.getNumPaths();
+    else
+      errs() << PN.getNumPaths();
     errs() << "\n";
 
+    // Without loops a depth-first enumeration produces the paths in ID
+    // order, so the paths the limit cut off start at the ID after the last
+    // one enumerated, and can be decoded from there
+    if (PE.getLimitHit() == BudgetLimit::Paths && !Budget.isBestFirst() &&
+        FAM.getResult<LoopAnalysis>(F).empty() && PC.isExact()) {
+      Path next;
+      if (PN.decode(paths.size(), next)) {
+        errs() << "  First path past the limit (ID " << paths.size() << "): ";
+        for (size_t i = 0; i < next.size(); ++i)
+          errs() << (i ? " -> " : "") << next[i]->getName();
+        errs() << "\n";
+      }
+    }
+
+    // Length statistics over every path with the loop bound, by a DP over
+    // the CFG of the enumeration rather than over its paths. The DP has the
+    // loop semantics of PathCounter, so its paths are the enumerated ones
+    // only where the count is exact: with nested loops it bounds iterations
+    // per loop entry rather than per path, and on irreducible CFGs it
+    // ignores retreating edges.
+    PathAlgebra Lengths(PathStatistics(), [](BasicBlock *) { return 1.0; });
+    if (auto length =
+            Lengths.solve(*PE.getCFG(), FAM.getResult<LoopAnalysis>(F),
+                          Budget.maxLoopIterations)) {
+      errs() << "  Path length (";
+      if (PC.isExact())
+        errs() << "all " << format("%g", length->count) << " paths, DP";
+      else if (PC.isUpperBound())
+        errs() << "at most " << format("%g", length->count)
+               << " paths, DP with the loop bound per loop entry";
+      else
+        errs() << "about " << format("%g", length->count)
+               << " paths, DP without retreating edges";
+      errs() << "): min " << format("%g", length->min) << ", max "
+             << format("%g", length->max) << ", mean "
+             << format("%.2f", length->mean()) << ", std dev "
+             << format("%.2f", std::sqrt(length->variance())) << "\n";
+    }
+
+    // The path expression stands for all paths over the CFG of the
+    // enumeration with any number of loop iterations, so the count is finite
+    // only for acyclic functions
+    PathExpression PX(PE.getCFG());
+    if (auto count = PX.evaluate(SlotCountAlgebra(Budget.uniqueSuccessors))) {
+      errs() << "  Path expression (" << PX.size() << " nodes): ";
+      PX.print(errs());
+      errs() << "\n  All paths (no loop bound): ";
+      if (*count == UINT64_MAX)
+        errs() << "unbounded";
+      else
+        errs() << *count;
+      errs() << "\n";
+    }
+
     // Optional: print paths for small path counts
-    if (PE.getPathCount() > 0 && PE.getPathCount() <= 20) {
-      const auto &paths = PE.getPaths();
+    if (paths.size() > 0 && paths.size() <= 20) {
       for (size_t i = 0; i < paths.size(); ++i) {
-        errs() << "  Path " << (i + 1) << " (length " << paths[i].size()
-               << "): ";
-        for (size_t j = 0; j < paths[i].size(); ++j) {
-          if (j > 0)
+        PathView path = paths[i];
+        errs() << "  Path " << (i + 1) << " (length " << path.size() << "): ";
+        bool first = true;
+        for (BasicBlock *BB : path) {
+          if (!first)
             errs() << " -> ";
-          errs() << paths[i][j]->getName();
+          errs() << BB->getName();
+          first = false;
         }
         errs() << "\n";
       }
-    } else if (PE.getPathCount() > 20) {
+    } else if (paths.size() > 20) {
       errs() << "  (Too many paths to display individually)\n";
     }
 
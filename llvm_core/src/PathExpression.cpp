@@ -0,0 +1,231 @@
+#include "PathExpression.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include <algorithm>
+#include <utility>
+
+using namespace llvm;
+using namespace hepf;
+
+PathExpression::PathExpression(std::shared_ptr<const CFGIndex> Index)
+    : CFG(std::move(Index)), root(None), entryIsExit(false) {
+  const CFGIndex &CFG = *this->CFG;
+  if (CFG.empty())
+    return;
+  if (CFG.isExit(0)) {
+    entryIsExit = true;
+    return;
+  }
+  const unsigned numBlocks = CFG.size();
+
+  // Reachable blocks in DFS post-order
+  std::vector<uint32_t> order;
+  std::vector<bool> visited(numBlocks, false);
+  std::vector<std::pair<uint32_t, unsigned>> stack;
+  visited[0] = true;
+  stack.push_back({0, CFG.edgeBegin(0)});
+  while (!stack.empty()) {
+    auto &[block, edge] = stack.back();
+    if (edge == CFG.edgeEnd(block)) {
+      order.push_back(block);
+      stack.pop_back();
+      continue;
+    }
+    uint32_t succ = CFG.getEdgeTarget(edge++);
+    if (!visited[succ]) {
+      visited[succ] = true;
+      stack.push_back({succ, CFG.edgeBegin(succ)});
+    }
+  }
+
+  // out[i][j] is the expression for the paths from i to j through the
+  // blocks removed so far; in[j] are the blocks with such paths to j. The
+  // map keeps successor order, so the expression does not depend on hashing.
+  std::vector<MapVector<uint32_t, uint32_t>> out(numBlocks);
+  std::vector<DenseSet<uint32_t>> in(numBlocks);
+  auto addPaths = [&](uint32_t from, uint32_t to, uint32_t expr) {
+    auto [it, inserted] = out[from].insert({to, expr});
+    if (!inserted)
+      it->second = make(Kind::Union, it->second, expr);
+    in[to].insert(from);
+  };
+  // Parallel edges are one term, not a union of identical ones
+  for (uint32_t block : order)
+    for (unsigned edge = CFG.edgeBegin(block); edge < CFG.edgeEnd(block);
+         ++edge) {
+      uint32_t succ = CFG.getEdgeTarget(edge);
+      if (!out[block].count(succ))
+        addPaths(block, succ, make(Kind::Edge, block, succ));
+    }
+
+  for (uint32_t k : order) {
+    if (k == 0 || CFG.isExit(k))
+      continue;
+    // The entry block has no predecessors, so every cycle goes through a
+    // removed block
+    uint32_t loop = None;
+    if (auto it = out[k].find(k); it != out[k].end())
+      loop = make(Kind::Star, it->second);
+
+    SmallVector<uint32_t, 8> preds(in[k].begin(), in[k].end());
+    llvm::sort(preds);
+    for (uint32_t i : preds) {
+      if (i == k)
+        continue;
+      uint32_t prefix = out[i].lookup(k);
+      out[i].erase(k);
+      if (loop != None)
+        prefix = make(Kind::Concat, prefix, loop);
+      for (const auto &[j, suffix] : out[k])
+        if (j != k)
+          addPaths(i, j, make(Kind::Concat, prefix, suffix));
+    }
+    for (const auto &[j, suffix] : out[k])
+      in[j].erase(k);
+    out[k].clear();
+    in[k].clear();
+  }
+
+  // Only exits are left behind the entry
+  for (const auto &[exit, expr] : out[0])
+    root = root == None ? expr : make(Kind::Union, root, expr);
+}
+
+uint32_t PathExpression::make(Kind kind, uint32_t lhs, uint32_t rhs) {
+  // Union is commutative: one node for both operand orders
+  if (kind == Kind::Union && lhs > rhs)
+    std::swap(lhs, rhs);
+  auto [it, inserted] =
+      uniqued.insert({std::make_tuple(uint8_t(kind), lhs, rhs), 0});
+  if (inserted) {
+    it->second = nodes.size();
+    nodes.push_back({kind, lhs, rhs});
+  }
+  return it->second;
+}
+
+std::vector<bool> PathExpression::getReachable() const {
+  std::vector<bool> reachable(nodes.size(), false);
+  if (root == None)
+    return reachable;
+  reachable[root] = true;
+  for (uint32_t n = root + 1; n-- > 0;) {
+    if (!reachable[n])
+      continue;
+    const Node &N = nodes[n];
+    if (N.kind == Kind::Edge)
+      continue;
+    reachable[N.lhs] = true;
+    if (N.kind != Kind::Star)
+      reachable[N.rhs] = true;
+  }
+  return reachable;
+}
+
+size_t PathExpression::size() const {
+  std::vector<bool> reachable = getReachable();
+  return std::count(reachable.begin(), reachable.end(), true);
+}
+
+void PathExpression::printNode(raw_ostream &OS, uint32_t node,
+                               ArrayRef<uint32_t> names,
+                               size_t &budget) const {
+  if (budget == 0)
+    return;
+  auto emit = [&](StringRef text) {
+    if (budget == 0)
+      return;
+    if (text.size() >= budget) {
+      OS << text.take_front(budget) << "...";
+      budget = 0;
+      return;
+    }
+    OS << text;
+    budget -= text.size();
+  };
+  auto emitBlock = [&](uint32_t block) {
+    BasicBlock *BB = CFG->getBlock(block);
+    if (BB->hasName())
+      emit(BB->getName());
+    else
+      emit(("#" + Twine(block)).str());
+  };
+  auto emitOperand = [&](uint32_t operand) {
+    if (names[operand] != None)
+      emit(("$" + Twine(names[operand])).str());
+    else
+      printNode(OS, operand, names, budget);
+  };
+
+  const Node &N = nodes[node];
+  switch (N.kind) {
+  case Kind::Edge:
+    emitBlock(N.lhs);
+    emit(">");
+    emitBlock(N.rhs);
+    break;
+  case Kind::Concat:
+    emitOperand(N.lhs);
+    emit(" ");
+    emitOperand(N.rhs);
+    break;
+  case Kind::Union:
+    emit("(");
+    emitOperand(N.lhs);
+    emit(" | ");
+    emitOperand(N.rhs);
+    emit(")");
+    break;
+  case Kind::Star:
+    emit("(");
+    emitOperand(N.lhs);
+    emit(")*");
+    break;
+  }
+}
+
+void PathExpression::print(raw_ostream &OS, size_t maxChars) const {
+  if (entryIsExit) {
+    OS << "<entry>";
+    return;
+  }
+  if (root == None) {
+    OS << "<no path>";
+    return;
+  }
+
+  // Every reachable compound node with more than one user gets a binding;
+  // edges are shorter than a name
+  std::vector<bool> reachable = getReachable();
+  std::vector<uint32_t> uses(root + 1, 0);
+  for (uint32_t n = 0; n <= root; ++n) {
+    const Node &N = nodes[n];
+    if (!reachable[n] || N.kind == Kind::Edge)
+      continue;
+    uses[N.lhs]++;
+    if (N.kind != Kind::Star)
+      uses[N.rhs]++;
+  }
+  std::vector<uint32_t> names(root + 1, None);
+  uint32_t numNames = 0;
+  size_t budget = maxChars;
+  // Operands precede their users, so bindings come before their uses
+  for (uint32_t n = 0; n < root && budget > 0; ++n) {
+    if (!reachable[n] || nodes[n].kind == Kind::Edge || uses[n] < 2)
+      continue;
+    names[n] = ++numNames;
+    std::string binding = ("$" + Twine(numNames) + " = ").str();
+    if (binding.size() >= budget) {
+      OS << StringRef(binding).take_front(budget) << "...";
+      return;
+    }
+    OS << binding;
+    budget -= binding.size();
+    printNode(OS, n, names, budget);
+    if (budget == 0)
+      return;
+    OS << "; ";
+    budget -= std::min<size_t>(budget, 2);
+  }
+  printNode(OS, root, names, budget);
+}
@@ -0,0 +1,197 @@
+#include "PathNumbering.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <utility>
+
+using namespace llvm;
+using namespace hepf;
+
+PathNumbering::PathNumbering(std::shared_ptr<const CFGIndex> CFG)
+    : CFG(std::move(CFG)), overflowed(false) {
+  if (this->CFG->empty())
+    return;
+
+  findBackEdges();
+  assignIncrements();
+}
+
+bool PathNumbering::isExitBlock(unsigned block) const {
+  return CFG->isExit(block);
+}
+
+void PathNumbering::findBackEdges() {
+  // Iterative DFS: an edge to a block that is still on the stack closes a
+  // cycle and is treated as a back edge
+  enum : uint8_t { Unvisited, OnStack, Done };
+  std::vector<uint8_t> state(CFG->size(), Unvisited);
+  isBackEdge.assign(CFG->getNumEdges(), false);
+  postOrder.reserve(CFG->size());
+
+  // (block, next edge to explore)
+  std::vector<std::pair<unsigned, unsigned>> stack;
+  stack.emplace_back(0, CFG->edgeBegin(0));
+  state[0] = OnStack;
+
+  while (!stack.empty()) {
+    auto &[block, edge] = stack.back();
+    if (edge == CFG->edgeEnd(block)) {
+      state[block] = Done;
+      postOrder.push_back(block);
+      stack.pop_back();
+      continue;
+    }
+
+    unsigned succ = CFG->getEdgeTarget(edge);
+    unsigned current = edge++;
+    if (state[succ] == OnStack) {
+      isBackEdge[current] = true;
+    } else if (state[succ] == Unvisited) {
+      state[succ] = OnStack;
+      stack.emplace_back(succ, CFG->edgeBegin(succ));
+    }
+  }
+}
+
+void PathNumbering::assignIncrements() {
+  numPaths.assign(CFG->size(), 0);
+  increments.assign(CFG->getNumEdges(), 0);
+
+  // Post-order visits every block after all of its acyclic successors
+  for (unsigned block : postOrder) {
+    if (isExitBlock(block)) {
+      numPaths[block] = 1;
+      continue;
+    }
+
+    uint64_t total = 0;
+    for (unsigned edge = CFG->edgeBegin(block); edge < CFG->edgeEnd(block);
+         ++edge) {
+      if (isBackEdge[edge])
+        continue;
+
+      increments[edge] = total;
+      uint64_t sum;
+      if (__builtin_add_overflow(total, numPaths[CFG->getEdgeTarget(edge)],
+                                 &sum)) {
+        overflowed = true;
+        sum = UINT64_MAX;
+      }
+      total = sum;
+    }
+    numPaths[block] = total;
+  }
+}
+
+uint64_t PathNumbering::getNumPaths() const {
+  if (CFG->empty())
+    return 0;
+  return overflowed ? UINT64_MAX : numPaths[0];
+}
+
+bool PathNumbering::decode(uint64_t pathID, Path &path) const {
+  path.clear();
+  if (overflowed || pathID >= getNumPaths())
+    return false;
+
+  unsigned block = 0;
+  llvm::append_range(path, CFG->getChain(block));
+  while (!isExitBlock(block)) {
+    // Take the last edge whose increment does not exceed the remaining ID;
+    // increments are non-decreasing along the successor list
+    unsigned chosen = 0;
+    bool found = false;
+    for (unsigned edge = CFG->edgeBegin(block); edge < CFG->edgeEnd(block);
+         ++edge) {
+      if (isBackEdge[edge] || numPaths[CFG->getEdgeTarget(edge)] == 0)
+        continue;
+      if (increments[edge] > pathID)
+        break;
+      chosen = edge;
+      found = true;
+    }
+
+    if (!found)
+      return false;
+
+    pathID -= increments[chosen];
+    block = CFG->getEdgeTarget(chosen);
+    llvm::append_range(path, CFG->getChain(block));
+  }
+
+  return pathID == 0;
+}
+
+std::optional<unsigned> PathNumbering::findEdge(unsigned block,
+                                                unsigned target) const {
+  for (unsigned edge = CFG->edgeBegin(block); edge < CFG->edgeEnd(block);
+       ++edge)
+    if (!isBackEdge[edge] && CFG->getEdgeTarget(edge) == target)
+      return edge;
+  return std::nullopt;
+}
+
+std::optional<uint64_t> PathNumbering::encode(const Path &path) const {
+  if (overflowed || path.empty() || CFG->empty() ||
+      path.front() != CFG->getBlock(0))
+    return std::nullopt;
+
+  // Map the blocks to nodes, a whole chain at a time
+  SmallVector<uint32_t, 32> nodes;
+  for (size_t i = 0; i < path.size();) {
+    if (path[i]->getParent() != path.front()->getParent())
+      return std::nullopt;
+    unsigned node = CFG->getIndex(path[i]);
+    ArrayRef<BasicBlock *> chain = CFG->getChain(node);
+    if (path.size() - i < chain.size() ||
+        !std::equal(chain.begin(), chain.end(), path.begin() + i))
+      return std::nullopt;
+    nodes.push_back(node);
+    i += chain.size();
+  }
+  return encode(nodes);
+}
+
+std::optional<uint64_t> PathNumbering::encode(ArrayRef<uint32_t> nodes) const {
+  if (overflowed || nodes.empty() || CFG->empty() || nodes.front() != 0)
+    return std::nullopt;
+
+  uint64_t pathID = 0;
+  for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+    std::optional<unsigned> edge = findEdge(nodes[i], nodes[i + 1]);
+    if (!edge)
+      return std::nullopt;
+    pathID += increments[*edge];
+  }
+
+  if (!isExitBlock(nodes.back()))
+    return std::nullopt;
+  return pathID;
+}
+
+std::optional<uint64_t> PathNumbering::getIncrement(BasicBlock *BB,
+                                                    unsigned successorIndex) const {
+  if (CFG->empty() || BB->getParent() != CFG->getBlock(0)->getParent())
+    return std::nullopt;
+
+  Instruction *Term = BB->getTerminator();
+  if (!Term || successorIndex >= Term->getNumSuccessors())
+    return std::nullopt;
+  unsigned block = CFG->getIndex(BB);
+  // The edges within a superblock are the only way on
+  if (CFG->getChain(block).back() != BB)
+    return 0;
+  // Every slot is an edge of its own, unless duplicates were merged into
+  // one edge per target
+  std::optional<unsigned> edge;
+  if (CFG->hasUniqueSuccessors()) {
+    edge = findEdge(block, CFG->getIndex(Term->getSuccessor(successorIndex)));
+  } else {
+    for (unsigned e = CFG->edgeBegin(block); e < CFG->edgeEnd(block); ++e)
+      if (CFG->getEdgeSlot(block, e) == successorIndex && !isBackEdge[e])
+        edge = e;
+  }
+  if (!edge)
+    return std::nullopt;
+  return increments[*edge];
+}
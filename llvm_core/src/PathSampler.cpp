@@ -0,0 +1,149 @@
+#include "PathSampler.h"
+#include "llvm/Support/Format.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace llvm;
+using namespace hepf;
+
+// -----------------------------------------------------------
+// PathSampler
+// -----------------------------------------------------------
+PathSampler::PathSampler(std::shared_ptr<const CFGIndex> CFG,
+                         size_t maxLoopIterations,
+                         const BranchProbabilityInfo *BPI, uint64_t seed)
+    : CFG(std::move(CFG)), maxLoopIterations(maxLoopIterations), rng(seed),
+      visitCount(this->CFG->size(), 0), logProbability(0.0), numRejected(0) {
+  if (BPI)
+    edgeWeights = this->CFG->getEdgeProbabilities(*BPI);
+}
+
+bool PathSampler::next() {
+  for (unsigned attempt = 0; attempt < MaxAttempts; ++attempt) {
+    if (walk())
+      return true;
+    numRejected++;
+  }
+  path.clear();
+  return false;
+}
+
+bool PathSampler::walk() {
+  for (uint32_t block : path)
+    visitCount[block] = 0;
+  path.clear();
+  logProbability = 0.0;
+  if (CFG->empty())
+    return false;
+
+  uint32_t block = 0;
+  visitCount[block]++;
+  path.push_back(block);
+
+  while (!CFG->isExit(block)) {
+    // Edges the walk may take without exceeding the loop bound
+    candidates.clear();
+    double total = 0.0;
+    for (unsigned edge = CFG->edgeBegin(block); edge < CFG->edgeEnd(block);
+         ++edge) {
+      double weight = isUniform() ? 1.0 : edgeWeights[edge];
+      if (weight > 0.0 &&
+          visitCount[CFG->getEdgeTarget(edge)] <= maxLoopIterations) {
+        candidates.push_back(edge);
+        total += weight;
+      }
+    }
+    if (candidates.empty())
+      return false;
+
+    // Choose an edge with probability weight / total
+    double point = std::uniform_real_distribution<double>(0.0, total)(rng);
+    unsigned chosen = candidates.back();
+    for (unsigned edge : candidates) {
+      double weight = isUniform() ? 1.0 : edgeWeights[edge];
+      if (point < weight) {
+        chosen = edge;
+        break;
+      }
+      point -= weight;
+    }
+
+    logProbability +=
+        std::log((isUniform() ? 1.0 : edgeWeights[chosen]) / total);
+    block = CFG->getEdgeTarget(chosen);
+    visitCount[block]++;
+    path.push_back(block);
+  }
+  return true;
+}
+
+// -----------------------------------------------------------
+// SampleEstimator
+// -----------------------------------------------------------
+void SampleEstimator::add(double value, double logWeight) {
+  maxValue = samples.empty() ? value : std::max(maxValue, value);
+  samples.push_back({value, logWeight});
+}
+
+std::vector<double> SampleEstimator::getNormalizedWeights() const {
+  double maxLogWeight = -INFINITY;
+  for (const Sample &S : samples)
+    maxLogWeight = std::max(maxLogWeight, S.logWeight);
+
+  std::vector<double> weights;
+  weights.reserve(samples.size());
+  for (const Sample &S : samples)
+    weights.push_back(std::exp(S.logWeight - maxLogWeight));
+  return weights;
+}
+
+double SampleEstimator::getMean() const {
+  if (samples.empty())
+    return 0.0;
+
+  std::vector<double> weights = getNormalizedWeights();
+  double sum = 0.0, weightSum = 0.0;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    sum += weights[i] * samples[i].value;
+    weightSum += weights[i];
+  }
+  return sum / weightSum;
+}
+
+double SampleEstimator::getConfidenceHalfWidth(double z) const {
+  if (samples.size() < 2)
+    return INFINITY;
+
+  // Delta-method variance of the self-normalized mean; for equal weights
+  // this is the sample variance divided by the sample count
+  std::vector<double> weights = getNormalizedWeights();
+  double mean = getMean();
+  double weightSum = 0.0, spread = 0.0;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    double deviation = samples[i].value - mean;
+    weightSum += weights[i];
+    spread += weights[i] * weights[i] * deviation * deviation;
+  }
+  double n = samples.size();
+  double variance = spread / (weightSum * weightSum) * n / (n - 1);
+  return z * std::sqrt(variance);
+}
+
+double SampleEstimator::getMissedMass() const {
+  // A set of paths with probability q is missed by n independent samples
+  // with probability (1 - q)^n; solve (1 - q)^n = 0.05 for q
+  if (samples.empty())
+    return 1.0;
+  return 1.0 - std::pow(0.05, 1.0 / samples.size());
+}
+
+void SampleEstimator::print(raw_ostream &OS, StringRef indent,
+                            StringRef metric, StringRef unit) const {
+  OS << indent << "Maximum " << metric << ": >= " << format("%g", getMax())
+     << unit << " (higher paths carry < "
+     << format("%.2f", getMissedMass() * 100)
+     << "% of the sampling probability, 95% confidence)\n";
+  OS << indent << "Average " << metric << ": " << format("%g", getMean())
+     << " +/- " << format("%g", getConfidenceHalfWidth()) << unit
+     << " (95% CI)\n";
+}
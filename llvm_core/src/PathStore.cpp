@@ -0,0 +1,110 @@
+#include "PathStore.h"
+#include "PathEnumerator.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Endian.h"
+
+using namespace llvm;
+using namespace hepf;
+
+static constexpr char Magic[4] = {'H', 'P', 'S', '1'};
+
+PathStore::PathStore(std::shared_ptr<const CFGIndex> CFG)
+    : CFG(std::move(CFG)), offsets(1, 0) {}
+
+void PathStore::append(ArrayRef<uint32_t> path) {
+  blocks.insert(blocks.end(), path.begin(), path.end());
+  offsets.push_back(blocks.size());
+}
+
+void PathStore::append(const PathStore &other, size_t count) {
+  count = std::min(count, other.size());
+  uint64_t base = blocks.size();
+  blocks.insert(blocks.end(), other.blocks.begin(),
+                other.blocks.begin() + other.offsets[count]);
+  for (size_t i = 1; i <= count; ++i)
+    offsets.push_back(base + other.offsets[i]);
+}
+
+size_t PathStore::append(PathStream &stream) {
+  size_t added = 0;
+  while (stream.next()) {
+    append(stream.currentIndices());
+    added++;
+  }
+  return added;
+}
+
+void PathStore::reserve(size_t numPaths, size_t numBlocks) {
+  offsets.reserve(numPaths + 1);
+  blocks.reserve(numBlocks);
+}
+
+void PathStore::clear() {
+  offsets.assign(1, 0);
+  blocks.clear();
+}
+
+void PathStore::shrinkToFit() {
+  offsets.shrink_to_fit();
+  blocks.shrink_to_fit();
+}
+
+size_t PathStore::getMemoryUsage() const {
+  return offsets.capacity() * sizeof(uint64_t) +
+         blocks.capacity() * sizeof(uint32_t);
+}
+
+// -----------------------------------------------------------
+// Serialization
+// -----------------------------------------------------------
+void PathStore::serialize(raw_ostream &OS) const {
+  support::endian::Writer W(OS, support::little);
+  OS.write(Magic, sizeof(Magic));
+  W.write<uint32_t>(CFG->size());
+  W.write<uint64_t>(size());
+  W.write<uint64_t>(blocks.size());
+  W.write(ArrayRef<uint64_t>(offsets));
+  W.write(ArrayRef<uint32_t>(blocks));
+}
+
+std::optional<PathStore>
+PathStore::deserialize(StringRef data, std::shared_ptr<const CFGIndex> CFG) {
+  using namespace support;
+  const size_t HeaderSize = sizeof(Magic) + 4 + 8 + 8;
+  if (data.size() < HeaderSize || !data.startswith(StringRef(Magic, 4)))
+    return std::nullopt;
+
+  const char *ptr = data.data() + sizeof(Magic);
+  uint32_t numCFGBlocks = endian::readNext<uint32_t, little, unaligned>(ptr);
+  uint64_t numPaths = endian::readNext<uint64_t, little, unaligned>(ptr);
+  uint64_t numBlocks = endian::readNext<uint64_t, little, unaligned>(ptr);
+  if (numCFGBlocks != CFG->size())
+    return std::nullopt;
+
+  // Guard the size computation below against overflow
+  uint64_t remaining = data.size() - HeaderSize;
+  if (numPaths >= remaining / 8 || numBlocks > remaining / 4 ||
+      (numPaths + 1) * 8 + numBlocks * 4 != remaining)
+    return std::nullopt;
+
+  PathStore store(std::move(CFG));
+  store.offsets.resize(numPaths + 1);
+  for (uint64_t &offset : store.offsets)
+    offset = endian::readNext<uint64_t, little, unaligned>(ptr);
+  store.blocks.resize(numBlocks);
+  for (uint32_t &block : store.blocks)
+    block = endian::readNext<uint32_t, little, unaligned>(ptr);
+
+  // Offsets must be monotonic and cover the block array exactly
+  if (store.offsets.front() != 0 || store.offsets.back() != numBlocks)
+    return std::nullopt;
+  for (size_t i = 1; i < store.offsets.size(); ++i) {
+    if (store.offsets[i] < store.offsets[i - 1])
+      return std::nullopt;
+  }
+  for (uint32_t block : store.blocks) {
+    if (block >= numCFGBlocks)
+      return std::nullopt;
+  }
+  return store;
+}
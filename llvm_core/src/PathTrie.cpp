@@ -0,0 +1,68 @@
+#include "PathTrie.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace hepf;
+
+PathTrie::PathTrie(PathStream &stream)
+    : CFG(stream.getCFG()), reachedLimit(false) {
+  // Trie node of each block on the current path, by depth
+  std::vector<uint32_t> spine;
+
+  while (stream.next()) {
+    size_t length = stream.currentIndices().size();
+
+    // Only the part below the branch point is new
+    spine.resize(std::min(spine.size(), stream.getSharedPrefixLength()));
+    for (size_t depth = spine.size(); depth < length; ++depth) {
+      uint32_t parent = depth == 0 ? NoParent : spine[depth - 1];
+      spine.push_back(nodes.size());
+      nodes.push_back({stream.currentBlockIndex(depth), parent});
+    }
+    leaves.push_back(spine.back());
+  }
+
+  nodes.shrink_to_fit();
+  leaves.shrink_to_fit();
+  reachedLimit = stream.hasReachedLimit();
+}
+
+PathTrie::PathTrie(const PathStore &paths)
+    : CFG(paths.getCFG()), reachedLimit(false) {
+  std::vector<uint32_t> spine;
+  ArrayRef<uint32_t> previous;
+
+  for (PathView path : paths) {
+    ArrayRef<uint32_t> blocks = path.getBlockIndices();
+
+    // Keep the longest common prefix with the previous path
+    size_t shared = 0;
+    size_t limit = std::min(previous.size(), blocks.size());
+    while (shared < limit && previous[shared] == blocks[shared])
+      shared++;
+
+    spine.resize(std::min(spine.size(), shared));
+    for (size_t depth = spine.size(); depth < blocks.size(); ++depth) {
+      uint32_t parent = depth == 0 ? NoParent : spine[depth - 1];
+      spine.push_back(nodes.size());
+      nodes.push_back({blocks[depth], parent});
+    }
+    leaves.push_back(spine.back());
+    previous = blocks;
+  }
+
+  nodes.shrink_to_fit();
+  leaves.shrink_to_fit();
+}
+
+void PathTrie::getPath(uint32_t node, Path &path) const {
+  path.clear();
+  for (uint32_t n = node; n != NoParent; n = nodes[n].parent)
+    path.push_back(CFG->getBlock(nodes[n].block));
+  std::reverse(path.begin(), path.end());
+}
+
+size_t PathTrie::getMemoryUsage() const {
+  return nodes.capacity() * sizeof(Node) +
+         leaves.capacity() * sizeof(uint32_t);
+}
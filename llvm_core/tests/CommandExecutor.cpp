@@ -1,8 +1,11 @@
 #include "CommandExecutor.h"
-#include <cstdio>  // For std::remove (file cleanup)
-#include <cstdlib> // For std::system
-#include <fstream> // For std::ifstream
-#include <sstream> // For std::ostringstream
+#include <array>     // For std::array
+#include <cstdio>    // For std::remove (file cleanup)
+#include <cstdlib>   // For std::system
+#include <fstream>   // For std::ifstream
+#include <memory>    // For std::unique_ptr
+#include <sstream>   // For std::ostringstream
+#include <stdexcept> // For std::runtime_error
 
 namespace fs = std::filesystem;
 
@@ -54,18 +57,25 @@ CommandResult
 CommandExecutor::run_opt_command(const std::string &source_file_name,
                                  const std::string &pass_name,
                                  const std::string &so_name) {
-  // 1. Setup paths for command and logs
+  // 1. Setup paths for command and logs. Hand-written .ll fixtures are read
+  // from the tests directory, compiled sources from /tmp.
   std::string ll_name = source_file_name;
-  ll_name.replace(ll_name.find(".cpp"), 4, ".ll");
-  fs::path ll_input_path = m_tmp_dir / ll_name;
+  fs::path ll_input_path;
+  if (fs::path(source_file_name).extension() == ".ll") {
+    ll_input_path = m_project_root / m_tests_subdir / ll_name;
+  } else {
+    ll_name.replace(ll_name.find(".cpp"), 4, ".ll");
+    ll_input_path = m_tmp_dir / ll_name;
+  }
   fs::path so_path = m_project_root / m_build_subdir / so_name;
 
   fs::path stdout_log_path = m_tmp_dir / ("opt_" + ll_name + "_stdout.log");
   fs::path stderr_log_path = m_tmp_dir / ("opt_" + ll_name + "_stderr.log");
 
-  // 2. Construct the base opt command
+  // 2. Construct the base opt command. The pipeline is quoted: parameters
+  // such as "max-path<auto;threshold=4>" contain shell metacharacters.
   std::string base_command = "opt -load-pass-plugin " + so_path.string() +
-                             " -passes=" + pass_name + " -disable-output " +
+                             " '-passes=" + pass_name + "' -disable-output " +
                              ll_input_path.string();
 
   // 3. Construct the full command with output redirection
@@ -24,7 +24,7 @@ public:
   /**
    * @brief Constructs and runs the opt pass command, capturing stdout/stderr.
    * @param source_file_name The name of the source file (to deduce the .ll
-   * file).
+   * file), or of a hand-written .ll fixture in the tests directory.
    * @param pass_name The name of the optimization pass.
    * @param so_name The name of the shared object/plugin file.
    * @return CommandResult containing success status, return code, and captured
@@ -3,6 +3,8 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <tuple>
+#include <vector>
 
 TEST(MaxPathPassTest, CorrectlyCalculatesMaxPath) {
   CommandExecutor executor(PROJECT_ROOT_PATH);
@@ -50,3 +52,109 @@ TEST(MaxPathPassTest, CorrectlyCalculatesMaxPath) {
                                  "4, Instructions: 12, MaxPath: 4") !=
               std::string::npos);
 }
+
+TEST(MaxPathPassTest, LoopCarriedMemoryDoesNotExceedFullScan) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The full scan only has edges to later instructions; the cheaper tiers
+  // must not add the store -> load recurrence of the next iteration
+  for (std::string tier : {"aa", "memoryssa", "full"}) {
+    CommandResult opt_result = executor.run_opt_command(
+        "test_maxpath_loop.ll", "max-path<" + tier + ">");
+    std::cout << "--- STDERR (" << tier << ") ---\n"
+              << opt_result.stderr_output;
+    ASSERT_TRUE(opt_result.success);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Function: counted, Basic Blocks: 3, Instructions: 9, "
+                    "MaxPath: 4\n") != std::string::npos);
+  }
+}
+
+TEST(MaxPathPassTest, PrecisionTiers) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  std::string test_file = "test_maxpath_tiers.ll";
+  // Expected MaxPath of @sw, @chain and @recurrence per tier
+  std::vector<std::tuple<std::string, std::string, std::string, std::string>>
+      tiers = {
+          {"usedef", "3", "3", "8"},
+          {"aa", "7", "5", "11"},
+          {"memoryssa", "7", "5", "11"},
+          {"full", "11", "5", "13"},
+      };
+  for (const auto &[tier, sw, chain, recurrence] : tiers) {
+    CommandResult opt_result =
+        executor.run_opt_command(test_file, "max-path<" + tier + ">");
+    std::cout << "--- STDERR (" << tier << ") ---\n"
+              << opt_result.stderr_output;
+    ASSERT_TRUE(opt_result.success);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Function: sw, Basic Blocks: 5, Instructions: 11, "
+                    "MaxPath: " + sw + "\n") != std::string::npos);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Function: chain, Basic Blocks: 7, Instructions: 10, "
+                    "MaxPath: " + chain + "\n") != std::string::npos);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Function: recurrence, Basic Blocks: 3, Instructions: 10, "
+                    "MaxPath: " + recurrence + "\n") != std::string::npos);
+  }
+
+  // @sw may reach the threshold and gets the full scan; @chain is bounded
+  // by 5 and keeps its use-def lower bound
+  CommandResult auto_result =
+      executor.run_opt_command(test_file, "max-path<auto;threshold=8>");
+  std::cout << "--- STDERR (auto) ---\n" << auto_result.stderr_output;
+  ASSERT_TRUE(auto_result.success);
+  ASSERT_TRUE(auto_result.stderr_output.find(
+                  "Function: sw, Basic Blocks: 5, Instructions: 11, "
+                  "MaxPath: 11\n") != std::string::npos);
+  ASSERT_TRUE(auto_result.stderr_output.find(
+                  "Function: chain, Basic Blocks: 7, Instructions: 10, "
+                  "MaxPath: 3 (use-def lower bound; at most 5, below "
+                  "threshold 8)\n") != std::string::npos);
+
+  // The full scan reaches 13 on @recurrence, so its upper bound must not
+  // fall below a threshold of 13
+  CommandResult recurrence_result =
+      executor.run_opt_command(test_file, "max-path<auto;threshold=13>");
+  std::cout << "--- STDERR (auto, recurrence) ---\n"
+            << recurrence_result.stderr_output;
+  ASSERT_TRUE(recurrence_result.success);
+  ASSERT_TRUE(recurrence_result.stderr_output.find(
+                  "Function: recurrence, Basic Blocks: 3, Instructions: 10, "
+                  "MaxPath: 13\n") != std::string::npos);
+}
+
+TEST(MaxPathPassTest, RejectsMalformedTiers) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // A threshold only applies to auto, and auto needs one
+  for (std::string params :
+       {"usedef;threshold=3", "auto", "auto;threshold=0", "exact"}) {
+    CommandResult opt_result = executor.run_opt_command(
+        "test_maxpath_tiers.ll", "max-path<" + params + ">");
+    std::cout << "--- STDERR (" << params << ") ---\n"
+              << opt_result.stderr_output;
+    ASSERT_FALSE(opt_result.success);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Invalid parameters for max-path: '" + params + "'") !=
+                std::string::npos);
+  }
+}
+
+TEST(MaxPathPassTest, MemorySSAWalkPassesIndependentDefinitions) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The add chain reaches the call through the store to @gp, past the
+  // nearer store to @gq: 3 adds, the store, the memory edge and the call
+  for (std::string tier : {"aa", "memoryssa", "full"}) {
+    CommandResult opt_result = executor.run_opt_command(
+        "test_maxpath_tiers.ll", "max-path<" + tier + ">");
+    std::cout << "--- STDERR (" << tier << ") ---\n"
+              << opt_result.stderr_output;
+    ASSERT_TRUE(opt_result.success);
+    ASSERT_TRUE(opt_result.stderr_output.find(
+                    "Function: farther, Basic Blocks: 1, Instructions: 7, "
+                    "MaxPath: 6\n") != std::string::npos);
+  }
+}
@@ -54,3 +54,73 @@ TEST(PathBasedCriticalSectionTraversalTest,
   ASSERT_TRUE(opt_result.stderr_output.find("Function: _Z11mixed_locksv, Path (BBs): [%0], Final Lock Depth: 0") !=
               std::string::npos);
 }
+
+TEST(PathBasedCriticalSectionTraversalTest, ExactlyMaxPathsIsComplete) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // 8 paths and a limit of 8: every path is analysed
+  CommandResult opt_result = executor.run_opt_command(
+      "test_path_limit.ll",
+      "path-based-critical-section-traversal<max-paths=8>");
+  std::cout << "--- STDERR ---\n" << opt_result.stderr_output;
+  ASSERT_TRUE(opt_result.success);
+  ASSERT_TRUE(opt_result.stderr_output.find(
+                  "Enumeration mode: exhaustive (8 paths)") !=
+              std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find("Path limit of 8 reached") ==
+              std::string::npos);
+}
+
+TEST(PathBasedCriticalSectionTraversalTest, LockDepthStatesOnNesting) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult opt_result = executor.run_opt_command(
+      "test_lock_depth.ll", "path-based-critical-section-traversal");
+  std::cout << "--- STDERR ---\n" << opt_result.stderr_output;
+  ASSERT_TRUE(opt_result.success);
+  const std::string &out = opt_result.stderr_output;
+
+  // Balanced nesting: every exit at depth 0 and no witness
+  ASSERT_TRUE(out.find("Function: balanced, Lock Depth States: 3, exit "
+                       "depths [0, 0]\n") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: balanced, Witness") == std::string::npos);
+
+  // A path that keeps the lock is the witness
+  ASSERT_TRUE(out.find("Function: unbalanced, Lock Depth States: 3, exit "
+                       "depths [0, 1]\n") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: unbalanced, Witness Path (BBs): [%entry -> "
+                       "%leak], Final Lock Depth: 1") != std::string::npos);
+
+  // 70 nested locks go beyond the tracked depth: the balanced path is
+  // approximate, not a witness of an unbalanced exit
+  ASSERT_TRUE(out.find("Function: deep, Lock Depth States: 2, exit depths "
+                       "unknown (APPROXIMATE: depths beyond 64 merged; "
+                       "approximate exit states: 1)\n") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: deep, Witness") == std::string::npos);
+
+  // Exact paths beside the deep one are still reported
+  ASSERT_TRUE(out.find("Function: deepunbalanced, Lock Depth States: 4, exit "
+                       "depths [1, 1] (APPROXIMATE") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: deepunbalanced, Witness Path (BBs): "
+                       "[%entry -> %leak], Final Lock Depth: 1") !=
+              std::string::npos);
+}
+
+TEST(PathBasedCriticalSectionTraversalTest, SuperblocksSumLockDeltas) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The 70 locks and 70 unlocks of @deep are one chain with a net delta of
+  // 0, so its single depth state is exact
+  CommandResult opt_result = executor.run_opt_command(
+      "test_lock_depth.ll",
+      "path-based-critical-section-traversal<superblocks>");
+  std::cout << "--- STDERR ---\n" << opt_result.stderr_output;
+  ASSERT_TRUE(opt_result.success);
+  const std::string &out = opt_result.stderr_output;
+  ASSERT_TRUE(out.find("Function: deep, Path (BBs): [%entry -> %release], "
+                       "Final Lock Depth: 0\n") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: deep, Lock Depth States: 1, exit depths "
+                       "[0, 0]\n") != std::string::npos);
+  ASSERT_TRUE(out.find("Function: unbalanced, Witness Path (BBs): [%entry -> "
+                       "%leak], Final Lock Depth: 1") != std::string::npos);
+}
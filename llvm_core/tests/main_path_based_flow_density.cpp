@@ -54,4 +54,73 @@ TEST(PathBasedFlowDensityTest, CorrectlyCalculatesPathBasedFlowDensity) {
               std::string::npos);
   ASSERT_TRUE(opt_result.stderr_output.find("Prob: 0.375000 | Entropy: 10.00 | FlowDensity: 3.750000e+00") !=
               std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find("blocks): 1.000000e+01") !=
+              std::string::npos);
+}
+
+TEST(PathBasedFlowDensityTest, PathExpressionSumsParallelSlots) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The switch slots into %a have weights 2, 3 and 1 (the default) of 8:
+  // its single expression edge is taken with 6/8, so every path is covered
+  // and the total is the entropy 7 of each path
+  for (const char *pass : {"path-based-flow-density",
+                           "path-based-flow-density<unique-successors>"}) {
+    CommandResult r =
+        executor.run_opt_command("test_duplicate_successors.ll", pass);
+    std::cout << "--- STDERR (" << pass << ") ---\n" << r.stderr_output;
+    ASSERT_TRUE(r.success);
+    ASSERT_TRUE(r.stderr_output.find(
+                    "Total FlowDensity (loop-exact, path expression of 12 "
+                    "nodes): 7.000000e+00") != std::string::npos);
+  }
+}
+
+TEST(PathBasedFlowDensityTest, MergedSwitchSlotsCarryTheirTotalProbability) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The path over the merged slots into %a has their weights 1 + 2 + 3 of 8
+  CommandResult r = executor.run_opt_command(
+      "test_duplicate_successors.ll",
+      "path-based-flow-density<unique-successors>");
+  std::cout << "--- STDERR ---\n" << r.stderr_output;
+  ASSERT_TRUE(r.success);
+  ASSERT_TRUE(r.stderr_output.find("Prob: 0.750000 | Entropy: 7.00 | "
+                                   "FlowDensity: 5.250000e+00\n"
+                                   "    Path: [entry → a → join → tail → "
+                                   "done]") != std::string::npos);
+  ASSERT_TRUE(r.stderr_output.find("Prob: 0.250000 | Entropy: 7.00 | "
+                                   "FlowDensity: 1.750000e+00\n"
+                                   "    Path: [entry → b → join → tail → "
+                                   "done]") != std::string::npos);
+  ASSERT_TRUE(r.stderr_output.find("Path entropy (by probability, 1.000000 "
+                                   "covered)") != std::string::npos);
+}
+
+TEST(PathBasedFlowDensityTest, PathTrieSharesPrefixes) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // 8 paths of 7 blocks through three diamonds share their prefixes: 1 + 2
+  // + 2 + 4 + 4 + 8 + 8 trie nodes
+  CommandResult diamonds = executor.run_opt_command(
+      "test_path_limit.ll", "path-based-flow-density");
+  std::cout << "--- STDERR ---\n" << diamonds.stderr_output;
+  ASSERT_TRUE(diamonds.success);
+  ASSERT_TRUE(diamonds.stderr_output.find("Path trie: 29 nodes for 8 paths "
+                                          "of 56 blocks in total\n") !=
+              std::string::npos);
+  // Every path extends the probability of its shared prefix: the branch
+  // heuristics weight each then-block 5/8 (first) and else-block 3/8 (last)
+  ASSERT_TRUE(diamonds.stderr_output.find("Prob: 0.244141 | Entropy: 10.00") !=
+              std::string::npos);
+  ASSERT_TRUE(diamonds.stderr_output.find("Prob: 0.052734 | Entropy: 10.00") !=
+              std::string::npos);
+
+  // 2048 paths of 24 blocks in a trie of 8190 nodes, a sixth of the copies
+  CommandResult many = executor.run_opt_command(
+      "test_many_paths.ll", "path-based-flow-density<max-paths=5000>");
+  ASSERT_TRUE(many.success);
+  ASSERT_TRUE(many.stderr_output.find("Path trie: 8190 nodes for 2048 paths "
+                                      "of 49152 blocks in total\n") !=
+              std::string::npos);
 }
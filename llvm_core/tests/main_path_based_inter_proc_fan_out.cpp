@@ -57,3 +57,109 @@ TEST(PathBasedInterProcFanOutTest, CorrectlyCalculatesPathBasedFanOut) {
                   "Average fan-out: 0.000000e+00") !=
               std::string::npos);
 }
+
+TEST(PathBasedInterProcFanOutTest, PhiTaintIsEdgeSensitive) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult opt_result = executor.run_opt_command(
+      "test_fan_out_phi.ll", "path-based-inter-proc-fan-out");
+  std::cout << "--- STDERR ---\n" << opt_result.stderr_output;
+
+  // An edge-insensitive PHI would also count the first @sink call: 3 and 2
+  ASSERT_TRUE(opt_result.success);
+  ASSERT_TRUE(opt_result.stderr_output.find(
+                  "Path 1 (length: 5 blocks): FanOut = 2") !=
+              std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find(
+                  "Path 2 (length: 3 blocks): FanOut = 1") !=
+              std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find("Maximum fan-out: 2") !=
+              std::string::npos);
+}
+
+TEST(PathBasedInterProcFanOutTest, BatchesAgreeWithPathByPathFanOut) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult opt_result = executor.run_opt_command(
+      "test_fan_out_batch.ll", "path-based-inter-proc-fan-out");
+  std::cout << "--- STDERR ---\n" << opt_result.stderr_output;
+
+  // Same figures as evaluating the 256 paths one at a time
+  ASSERT_TRUE(opt_result.success);
+  ASSERT_TRUE(opt_result.stderr_output.find("Total paths analyzed: 256") !=
+              std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find("Maximum fan-out: 6") !=
+              std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find(
+                  "Average fan-out: 2.843750e+00") != std::string::npos);
+}
+
+TEST(PathBasedInterProcFanOutTest, IncrementalFanOutMatchesPerPath) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // The undo log against paths evaluated from scratch: with two iterations
+  // the DFS leaves PHIs tainted in an %l iteration for an %r one
+  CommandResult incremental = executor.run_opt_command(
+      "test_fan_out_undo.ll",
+      "path-based-inter-proc-fan-out<max-loop-iterations=2>");
+  CommandResult perPath = executor.run_opt_command(
+      "test_fan_out_undo.ll",
+      "path-based-inter-proc-fan-out<max-loop-iterations=2;per-path>");
+  std::cout << "--- STDERR ---\n" << incremental.stderr_output;
+  ASSERT_TRUE(incremental.success);
+  ASSERT_TRUE(perPath.success);
+  ASSERT_EQ(incremental.stderr_output, perPath.stderr_output);
+
+  // l,l / l,r / l / r,l / r,r / r / no iteration. A PHI left tainted by the
+  // first three paths would count @sink in the fourth.
+  for (const char *line : {"Path 1 (length: 11 blocks): FanOut = 4\n",
+                           "Path 2 (length: 11 blocks): FanOut = 4\n",
+                           "Path 3 (length: 7 blocks): FanOut = 3\n",
+                           "Path 4 (length: 11 blocks): FanOut = 3\n",
+                           "Path 5 (length: 11 blocks): FanOut = 1\n",
+                           "Path 6 (length: 7 blocks): FanOut = 1\n",
+                           "Path 7 (length: 3 blocks): FanOut = 1\n"}) {
+    ASSERT_TRUE(incremental.stderr_output.find(line) != std::string::npos);
+  }
+
+  // ... and the same for the loop-carried PHI of test_fan_out_phi.ll and for
+  // the bit-parallel batches over acyclic functions
+  for (const char *fixture : {"test_fan_out_phi.ll", "test_fan_out_batch.ll"}) {
+    CommandResult fast =
+        executor.run_opt_command(fixture, "path-based-inter-proc-fan-out");
+    CommandResult slow = executor.run_opt_command(
+        fixture, "path-based-inter-proc-fan-out<per-path>");
+    ASSERT_TRUE(fast.success);
+    ASSERT_TRUE(slow.success);
+    ASSERT_EQ(fast.stderr_output, slow.stderr_output);
+  }
+}
+
+TEST(PathBasedInterProcFanOutTest, SampledEstimateIsSeededAndCoversExact) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // Over the limit of 4 paths, @dia's 256 paths are sampled instead
+  CommandResult sampled = executor.run_opt_command(
+      "test_fan_out_batch.ll", "path-based-inter-proc-fan-out<max-paths=4>");
+  CommandResult again = executor.run_opt_command(
+      "test_fan_out_batch.ll", "path-based-inter-proc-fan-out<max-paths=4>");
+  std::cout << "--- STDERR ---\n" << sampled.stderr_output;
+  ASSERT_TRUE(sampled.success);
+  ASSERT_TRUE(again.success);
+
+  // The seed is fixed, so every run draws the same walks
+  ASSERT_EQ(sampled.stderr_output, again.stderr_output);
+  size_t dia = sampled.stderr_output.find("Summary for dia:");
+  ASSERT_NE(dia, std::string::npos);
+  std::string estimate = sampled.stderr_output.substr(dia);
+  ASSERT_TRUE(estimate.find("Sampled estimate (1000 random paths):") !=
+              std::string::npos);
+
+  // The exhaustive figures are a maximum of 6 and an average of 2.84375
+  // (BatchesAgreeWithPathByPathFanOut): the sampled maximum reaches the
+  // true one, and the inverse-probability weighted mean has it within its
+  // 95% interval
+  ASSERT_TRUE(estimate.find("Maximum fan-out: >= 6 ") != std::string::npos);
+  ASSERT_TRUE(estimate.find("Average fan-out: 2.835 +/- 0.0990591 (95% CI)") !=
+              std::string::npos);
+}
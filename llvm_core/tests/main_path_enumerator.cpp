@@ -1,5 +1,6 @@
 #include "CommandExecutor.h"
 #include "gtest/gtest.h"
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -50,4 +51,456 @@ TEST(PathEnumeratorTest, CorrectlyEnumeratesPaths) {
   ASSERT_TRUE(opt_result.stderr_output.find(
                   "Analyzing function: _Z23test_function_for_pathsi") !=
               std::string::npos);
+  ASSERT_TRUE(opt_result.stderr_output.find(
+                  "Acyclic paths (Ball-Larus): 2") != std::string::npos);
+}
+
+TEST(PathEnumeratorTest, PathLimitDoesNotDependOnThreadCount) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // Hand-written IR with exactly 8 paths
+  std::string test_file = "test_path_limit.ll";
+
+  for (std::string threads : {"1", "4"}) {
+    // Exactly maxPaths paths: the enumeration is complete
+    CommandResult complete = executor.run_opt_command(
+        test_file, "path-enumerator<max-paths=8;threads=" + threads + ">");
+    std::cout << "--- STDERR (threads=" << threads << ", max-paths=8) ---\n"
+              << complete.stderr_output;
+    ASSERT_TRUE(complete.success);
+    ASSERT_TRUE(complete.stderr_output.find("Paths found: 8\n") !=
+                std::string::npos);
+    ASSERT_TRUE(complete.stderr_output.find("LIMIT REACHED") ==
+                std::string::npos);
+
+    // One path more than maxPaths: the limit is reached
+    CommandResult limited = executor.run_opt_command(
+        test_file, "path-enumerator<max-paths=7;threads=" + threads + ">");
+    std::cout << "--- STDERR (threads=" << threads << ", max-paths=7) ---\n"
+              << limited.stderr_output;
+    ASSERT_TRUE(limited.success);
+    ASSERT_TRUE(limited.stderr_output.find(
+                    "Paths found: 7 (LIMIT REACHED - incomplete enumeration)") !=
+                std::string::npos);
+  }
+}
+
+TEST(PathEnumeratorTest, LogsEnumerationMode) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // 8 paths: below the default limit, enumerated exhaustively
+  CommandResult exhaustive =
+      executor.run_opt_command("test_path_limit.ll", "path-enumerator");
+  std::cout << "--- STDERR (test_path_limit.ll) ---\n"
+            << exhaustive.stderr_output;
+  ASSERT_TRUE(exhaustive.success);
+  ASSERT_TRUE(exhaustive.stderr_output.find(
+                  "Enumeration mode: exhaustive (8 paths)") !=
+              std::string::npos);
+
+  // 2048 paths: above the default limit of 1000, the first 1000 are enumerated
+  CommandResult truncated =
+      executor.run_opt_command("test_many_paths.ll", "path-enumerator");
+  std::cout << "--- STDERR (test_many_paths.ll) ---\n"
+            << truncated.stderr_output;
+  ASSERT_TRUE(truncated.success);
+  ASSERT_TRUE(truncated.stderr_output.find(
+                  "Enumeration mode: first 1000 paths (2048 paths > limit "
+                  "1000)") != std::string::npos);
+  ASSERT_TRUE(truncated.stderr_output.find(
+                  "Paths found: 1000 (LIMIT REACHED - incomplete "
+                  "enumeration)") != std::string::npos);
+}
+
+TEST(PathEnumeratorTest, ReportsBudgetLimits) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // 2^24 paths: no time or memory budget below lets the enumeration finish
+  std::string test_file = "test_budget.ll";
+
+  CommandResult paths = executor.run_opt_command(
+      test_file, "path-enumerator<max-paths=100;time-ms=60000;mem-mb=64>");
+  std::cout << "--- STDERR (max-paths=100) ---\n" << paths.stderr_output;
+  ASSERT_TRUE(paths.success);
+  ASSERT_TRUE(paths.stderr_output.find(
+                  "Paths found: 100 (LIMIT REACHED - incomplete "
+                  "enumeration)") != std::string::npos);
+
+  CommandResult time = executor.run_opt_command(
+      test_file, "path-enumerator<max-paths=100000000;time-ms=1>");
+  std::cout << "--- STDERR (time-ms=1) ---\n" << time.stderr_output;
+  ASSERT_TRUE(time.success);
+  ASSERT_TRUE(time.stderr_output.find(
+                  "(Time budget reached (time-ms=1) - incomplete "
+                  "enumeration)") != std::string::npos);
+
+  CommandResult memory = executor.run_opt_command(
+      test_file, "path-enumerator<max-paths=100000000;mem-mb=1>");
+  std::cout << "--- STDERR (mem-mb=1) ---\n" << memory.stderr_output;
+  ASSERT_TRUE(memory.success);
+  ASSERT_TRUE(memory.stderr_output.find(
+                  "(Memory budget reached (mem-mb=1) - incomplete "
+                  "enumeration)") != std::string::npos);
+
+  // 2048 equally likely paths: half of them cover half the probability
+  CommandResult coverage = executor.run_opt_command(
+      "test_many_paths.ll", "path-enumerator<max-paths=2000;coverage=0.5>");
+  std::cout << "--- STDERR (coverage=0.5) ---\n" << coverage.stderr_output;
+  ASSERT_TRUE(coverage.success);
+  ASSERT_TRUE(coverage.stderr_output.find(
+                  "Enumeration mode: best-first (2048 paths > limit 2000)") !=
+              std::string::npos);
+  ASSERT_TRUE(coverage.stderr_output.find(
+                  "Paths found: 1024 (Coverage target reached (coverage=0.5) "
+                  "- incomplete enumeration)") != std::string::npos);
+}
+
+TEST(PathEnumeratorTest, RejectsMalformedBudgets) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  for (std::string params :
+       {"max-paths=abc", "time-ms=", "mem-mb=-1", "coverage=2", "bogus=1"}) {
+    CommandResult result = executor.run_opt_command(
+        "test_path_limit.ll", "path-enumerator<" + params + ">");
+    std::cout << "--- STDERR (" << params << ") ---\n" << result.stderr_output;
+    ASSERT_FALSE(result.success);
+    ASSERT_TRUE(result.stderr_output.find(
+                    "Invalid parameters for path-enumerator: '" + params +
+                    "'") != std::string::npos);
+  }
+}
+
+// The part of the pass output that belongs to one function
+static std::string functionOutput(const std::string &output,
+                                  const std::string &function) {
+  size_t begin = output.find("Analyzing function: " + function + "\n");
+  if (begin == std::string::npos)
+    return "";
+  size_t end = output.find("Analyzing function: ", begin + 1);
+  return output.substr(begin, end == std::string::npos ? end : end - begin);
+}
+
+TEST(PathEnumeratorTest, PrunesColdAndNoreturnPaths) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult all = executor.run_opt_command("test_prune_cold.ll",
+                                               "path-enumerator");
+  CommandResult pruned = executor.run_opt_command(
+      "test_prune_cold.ll", "path-enumerator<prune-cold>");
+  std::cout << "--- STDERR (prune-cold) ---\n" << pruned.stderr_output;
+  ASSERT_TRUE(all.success);
+  ASSERT_TRUE(pruned.success);
+
+  // Assertion failures, the cold call and the loop's rare exit: 19 -> 6
+  std::string checked = functionOutput(pruned.stderr_output, "checked");
+  ASSERT_TRUE(functionOutput(all.stderr_output, "checked")
+                  .find("Paths found: 19\n") != std::string::npos);
+  ASSERT_TRUE(checked.find("Paths found: 6\n") != std::string::npos);
+  ASSERT_TRUE(checked.find("Pruned paths (cold or noreturn): 13 at 3 "
+                           "edges") != std::string::npos);
+  ASSERT_TRUE(checked.find("Path 6 (length 7): entry -> ok0 -> ok1 -> loop "
+                           "-> done -> b -> ret") != std::string::npos);
+
+  // The loop only leaves through a noreturn call: one edge into it goes
+  std::string spin = functionOutput(pruned.stderr_output, "spin");
+  ASSERT_TRUE(spin.find("Paths found: 1\n") != std::string::npos);
+  ASSERT_TRUE(spin.find("Pruned paths (cold or noreturn): 3 at 1 edges") !=
+              std::string::npos);
+  ASSERT_TRUE(spin.find("Path 1 (length 2): entry -> ret") !=
+              std::string::npos);
+
+  // Pruning every exit would leave no path at all, so nothing is pruned
+  std::string spinonly = functionOutput(pruned.stderr_output, "spinonly");
+  ASSERT_TRUE(spinonly.find("Paths found: 6\n") != std::string::npos);
+  ASSERT_TRUE(spinonly.find("Pruned paths (cold or noreturn): 0 at 0 "
+                            "edges") != std::string::npos);
+}
+
+TEST(PathEnumeratorTest, PathExpressionFollowsEnumerationCFG) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // Subexpressions shared by both arms of a diamond print once, as bindings
+  CommandResult diamonds =
+      executor.run_opt_command("test_path_limit.ll", "path-enumerator");
+  ASSERT_TRUE(diamonds.success);
+  ASSERT_TRUE(diamonds.stderr_output.find(
+                  "Path expression (25 nodes): "
+                  "$1 = (join2>then3 then3>join3 | join2>else3 else3>join3); "
+                  "$2 = (join1>then2 then2>join2 $1 | "
+                  "join1>else2 else2>join2 $1); "
+                  "(entry>then1 then1>join1 $2 | entry>else1 else1>join1 $2)") !=
+              std::string::npos);
+  ASSERT_TRUE(diamonds.stderr_output.find("All paths (no loop bound): 8\n") !=
+              std::string::npos);
+
+  // Three switch slots into one block are a single edge of the expression,
+  // which counts them as the enumeration does
+  CommandResult slots = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator");
+  CommandResult unique = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator<unique-successors>");
+  CommandResult chains = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator<superblocks>");
+  std::cout << "--- STDERR (duplicate successors) ---\n" << slots.stderr_output;
+  ASSERT_TRUE(slots.success);
+  ASSERT_TRUE(unique.success);
+  ASSERT_TRUE(chains.success);
+  ASSERT_TRUE(slots.stderr_output.find(
+                  "Path expression (12 nodes): $1 = join>tail tail>done; "
+                  "(entry>a a>join $1 | entry>b b>join $1)\n") !=
+              std::string::npos);
+  ASSERT_TRUE(slots.stderr_output.find("All paths (no loop bound): 4\n") !=
+              std::string::npos);
+  ASSERT_TRUE(unique.stderr_output.find("All paths (no loop bound): 2\n") !=
+              std::string::npos);
+  // The chain join -> tail -> done is one node
+  ASSERT_TRUE(chains.stderr_output.find(
+                  "Path expression (7 nodes): "
+                  "(entry>a a>join | entry>b b>join)\n") != std::string::npos);
+  ASSERT_TRUE(chains.stderr_output.find("All paths (no loop bound): 4\n") !=
+              std::string::npos);
+
+  // Pruned edges are not in the expression either
+  CommandResult pruned = executor.run_opt_command(
+      "test_prune_cold.ll", "path-enumerator<prune-cold>");
+  ASSERT_TRUE(pruned.success);
+  ASSERT_TRUE(functionOutput(pruned.stderr_output, "checked")
+                  .find("Path expression (20 nodes): entry>ok0 ok0>ok1 "
+                        "ok1>loop (loop>body body>loop)* loop>done "
+                        "(done>a a>ret | done>b b>ret)\n") !=
+              std::string::npos);
+  ASSERT_TRUE(functionOutput(pruned.stderr_output, "spin")
+                  .find("Path expression (1 nodes): entry>ret\n") !=
+              std::string::npos);
+}
+
+TEST(PathEnumeratorTest, LabelsPathLengthDPByItsLoopSemantics) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult r =
+      executor.run_opt_command("test_loop_bounds.ll", "path-enumerator");
+  std::cout << "--- STDERR ---\n" << r.stderr_output;
+  ASSERT_TRUE(r.success);
+
+  // The inner loop is bounded per entry by the DP but per path by the
+  // enumeration, so the DP covers more paths than are enumerated
+  std::string nested = functionOutput(r.stderr_output, "nested");
+  ASSERT_TRUE(nested.find("Paths found: 7\n") != std::string::npos);
+  ASSERT_TRUE(nested.find("Path length (at most 39 paths, DP with the loop "
+                          "bound per loop entry)") != std::string::npos);
+
+  // The DP does not take the retreating edges of the cycle at all
+  std::string irreducible = functionOutput(r.stderr_output, "irreducible");
+  ASSERT_TRUE(irreducible.find("Paths found: 12\n") != std::string::npos);
+  ASSERT_TRUE(irreducible.find("Path length (about 3 paths, DP without "
+                               "retreating edges)") != std::string::npos);
+
+  // Without loops the DP is over the enumerated paths
+  CommandResult acyclic =
+      executor.run_opt_command("test_path_limit.ll", "path-enumerator");
+  ASSERT_TRUE(acyclic.success);
+  ASSERT_TRUE(acyclic.stderr_output.find("Path length (all 8 paths, DP): "
+                                         "min 7, max 7") != std::string::npos);
+}
+
+TEST(PathEnumeratorTest, NumbersPathsOverEnumerationCFG) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // Paths 0..4 are enumerated; ID 5 decodes to else1, then2, else3
+  CommandResult diamonds = executor.run_opt_command(
+      "test_path_limit.ll", "path-enumerator<max-paths=5>");
+  std::cout << "--- STDERR ---\n" << diamonds.stderr_output;
+  ASSERT_TRUE(diamonds.success);
+  ASSERT_TRUE(diamonds.stderr_output.find("Acyclic paths (Ball-Larus): 8\n") !=
+              std::string::npos);
+  ASSERT_TRUE(diamonds.stderr_output.find(
+                  "First path past the limit (ID 5): entry -> else1 -> join1 "
+                  "-> then2 -> join2 -> else3 -> join3\n") !=
+              std::string::npos);
+
+  // Every switch slot has its own ID unless duplicates are merged; decoded
+  // paths list every block of a superblock
+  CommandResult slots = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator<max-paths=2>");
+  CommandResult merged = executor.run_opt_command(
+      "test_duplicate_successors.ll",
+      "path-enumerator<max-paths=1;unique-successors;superblocks>");
+  ASSERT_TRUE(slots.success);
+  ASSERT_TRUE(merged.success);
+  ASSERT_TRUE(slots.stderr_output.find("Acyclic paths (Ball-Larus): 4\n") !=
+              std::string::npos);
+  ASSERT_TRUE(slots.stderr_output.find(
+                  "First path past the limit (ID 2): entry -> a -> join -> "
+                  "tail -> done\n") != std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find("Acyclic paths (Ball-Larus): 2\n") !=
+              std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find(
+                  "First path past the limit (ID 1): entry -> b -> join -> "
+                  "tail -> done\n") != std::string::npos);
+
+  // Pruned edges are not numbered
+  CommandResult pruned = executor.run_opt_command(
+      "test_prune_cold.ll", "path-enumerator<prune-cold>");
+  ASSERT_TRUE(pruned.success);
+  ASSERT_TRUE(functionOutput(pruned.stderr_output, "spin")
+                  .find("Acyclic paths (Ball-Larus): 1\n") !=
+              std::string::npos);
+}
+
+TEST(PathEnumeratorTest, UniqueSuccessorsMergesDuplicateSwitchTargets) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // Three switch slots into %a are three paths, which a limit of 2 cuts
+  CommandResult slots = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator<max-paths=2>");
+  CommandResult merged = executor.run_opt_command(
+      "test_duplicate_successors.ll",
+      "path-enumerator<max-paths=2;unique-successors>");
+  std::cout << "--- STDERR (unique-successors) ---\n" << merged.stderr_output;
+  ASSERT_TRUE(slots.success);
+  ASSERT_TRUE(merged.success);
+  ASSERT_TRUE(slots.stderr_output.find("Enumeration mode: first 2 paths (4 "
+                                       "paths > limit 2)") !=
+              std::string::npos);
+  ASSERT_TRUE(slots.stderr_output.find("Paths found: 2 (LIMIT REACHED") !=
+              std::string::npos);
+
+  // Merged, they are one path that stands for all three
+  ASSERT_TRUE(merged.stderr_output.find("Enumeration mode: exhaustive (2 "
+                                        "paths)") != std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find("Paths found: 2 (4 with duplicate "
+                                        "successors)\n") != std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find("Path 1 (length 5): entry -> a -> "
+                                        "join -> tail -> done\n") !=
+              std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find("Path 2 (length 5): entry -> b -> "
+                                        "join -> tail -> done\n") !=
+              std::string::npos);
+  ASSERT_TRUE(merged.stderr_output.find("Path 3 ") == std::string::npos);
+}
+
+TEST(PathEnumeratorTest, SuperblocksContractChainsAndExpandPaths) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  CommandResult blocks = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator");
+  CommandResult chains = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-enumerator<superblocks>");
+  std::cout << "--- STDERR (superblocks) ---\n" << chains.stderr_output;
+  ASSERT_TRUE(blocks.success);
+  ASSERT_TRUE(chains.success);
+
+  // join -> tail -> done is one node, and the paths over the nodes are the
+  // paths over the blocks, printed block by block
+  ASSERT_TRUE(chains.stderr_output.find("Superblocks: 4 nodes for 6 "
+                                        "blocks\n") != std::string::npos);
+  ASSERT_TRUE(chains.stderr_output.find("Paths found: 4\n") !=
+              std::string::npos);
+  for (const char *path : {"Path 1 (length 5): entry -> a -> join -> tail "
+                           "-> done\n",
+                           "Path 4 (length 5): entry -> b -> join -> tail "
+                           "-> done\n"}) {
+    ASSERT_TRUE(blocks.stderr_output.find(path) != std::string::npos);
+    ASSERT_TRUE(chains.stderr_output.find(path) != std::string::npos);
+  }
+
+  // Per-chain summaries give the metrics of the blocks they stand for
+  CommandResult maxPath = executor.run_opt_command(
+      "test_duplicate_successors.ll", "path-based-max-path<superblocks>");
+  ASSERT_TRUE(maxPath.success);
+  ASSERT_TRUE(maxPath.stderr_output.find("Path 4 (BB count: 5, critical "
+                                         "path: 5 instructions)") !=
+              std::string::npos);
+}
+
+TEST(PathEnumeratorTest, SavedPathsRoundTrip) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "hepf_saved_paths";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::string file = (dir / "diamonds.paths").string();
+
+  // 8 paths of 7 blocks: magic, CFG size and counts, 9 offsets and 56
+  // block indices
+  CommandResult out = executor.run_opt_command(
+      "test_path_limit.ll", "path-enumerator<paths-out=" + dir.string() + ">");
+  std::cout << "--- STDERR (out) ---\n" << out.stderr_output;
+  ASSERT_TRUE(out.success);
+  ASSERT_TRUE(out.stderr_output.find("Paths written to " + file +
+                                     " (320 bytes)\n") != std::string::npos);
+
+  // Reading them back gives the same paths in the same order
+  CommandResult in = executor.run_opt_command(
+      "test_path_limit.ll", "path-enumerator<paths-in=" + dir.string() + ">");
+  ASSERT_TRUE(in.success);
+  ASSERT_TRUE(in.stderr_output.find("Stored paths in " + file +
+                                    ": 8, same as enumerated\n") !=
+              std::string::npos);
+
+  // ... and different ones from a truncated enumeration
+  CommandResult limited = executor.run_opt_command(
+      "test_path_limit.ll",
+      "path-enumerator<max-paths=5;paths-in=" + dir.string() + ">");
+  ASSERT_TRUE(limited.success);
+  ASSERT_TRUE(limited.stderr_output.find("Stored paths in " + file +
+                                         ": 8, different from enumerated\n") !=
+              std::string::npos);
+
+  // A truncated file is rejected rather than read past its end
+  std::filesystem::resize_file(file, 10);
+  CommandResult truncated = executor.run_opt_command(
+      "test_path_limit.ll", "path-enumerator<paths-in=" + dir.string() + ">");
+  ASSERT_TRUE(truncated.success);
+  ASSERT_TRUE(truncated.stderr_output.find("Stored paths in " + file +
+                                           ": malformed or for another "
+                                           "CFG\n") != std::string::npos);
+
+  // So are paths over another CFG: superblock nodes are not blocks
+  CommandResult chains = executor.run_opt_command(
+      "test_duplicate_successors.ll",
+      "path-enumerator<superblocks;paths-out=" + dir.string() + ">");
+  ASSERT_TRUE(chains.success);
+  CommandResult blocks = executor.run_opt_command(
+      "test_duplicate_successors.ll",
+      "path-enumerator<paths-in=" + dir.string() + ">");
+  ASSERT_TRUE(blocks.success);
+  ASSERT_TRUE(blocks.stderr_output.find("dispatch.paths: malformed or for "
+                                        "another CFG\n") != std::string::npos);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(PathEnumeratorTest, PruneColdEnumerationsFollowCallChanges) {
+  CommandExecutor executor(PROJECT_ROOT_PATH);
+
+  // instcombine deletes the side-effect-free cold call but keeps the CFG,
+  // which keeps cached enumerations alive unless they prune cold code
+  CommandResult pruned = executor.run_opt_command(
+      "test_prune_cold_stale.ll", "path-enumerator<prune-cold>,"
+                                  "function(instcombine),"
+                                  "path-enumerator<prune-cold>");
+  std::cout << "--- STDERR (prune-cold) ---\n" << pruned.stderr_output;
+  ASSERT_TRUE(pruned.success);
+  size_t second = pruned.stderr_output.rfind("=== Path Enumerator Pass ===");
+  std::string before = pruned.stderr_output.substr(0, second);
+  std::string after = pruned.stderr_output.substr(second);
+  ASSERT_TRUE(before.find("Paths found: 1\n") != std::string::npos);
+  ASSERT_TRUE(before.find("Pruned paths (cold or noreturn): 1 at 1 edges\n") !=
+              std::string::npos);
+  ASSERT_TRUE(after.find("Paths found: 2\n") != std::string::npos);
+  ASSERT_TRUE(after.find("Pruned paths (cold or noreturn): 0 at 0 edges\n") !=
+              std::string::npos);
+
+  // Without prune-cold the second pass reuses the cached enumeration
+  CommandResult kept = executor.run_opt_command(
+      "test_prune_cold_stale.ll",
+      "path-enumerator,function(instcombine),path-enumerator");
+  ASSERT_TRUE(kept.success);
+  second = kept.stderr_output.rfind("=== Path Enumerator Pass ===");
+  ASSERT_TRUE(kept.stderr_output.substr(second).find("Paths found: 2\n") !=
+              std::string::npos);
+  ASSERT_TRUE(kept.stderr_output.substr(second).find(
+                  "=== Path Enumerator ===") == std::string::npos);
 }
@@ -0,0 +1,249 @@
+; 24 diamonds in a row: 2^24 paths, more than any time or memory budget
+; in the tests lets the enumeration finish.
+define i32 @huge(i32 %a) {
+entry:
+  br label %join0
+
+join0:
+  %c1 = icmp sgt i32 %a, 1
+  br i1 %c1, label %then1, label %else1
+
+then1:
+  br label %join1
+
+else1:
+  br label %join1
+
+join1:
+  %c2 = icmp sgt i32 %a, 2
+  br i1 %c2, label %then2, label %else2
+
+then2:
+  br label %join2
+
+else2:
+  br label %join2
+
+join2:
+  %c3 = icmp sgt i32 %a, 3
+  br i1 %c3, label %then3, label %else3
+
+then3:
+  br label %join3
+
+else3:
+  br label %join3
+
+join3:
+  %c4 = icmp sgt i32 %a, 4
+  br i1 %c4, label %then4, label %else4
+
+then4:
+  br label %join4
+
+else4:
+  br label %join4
+
+join4:
+  %c5 = icmp sgt i32 %a, 5
+  br i1 %c5, label %then5, label %else5
+
+then5:
+  br label %join5
+
+else5:
+  br label %join5
+
+join5:
+  %c6 = icmp sgt i32 %a, 6
+  br i1 %c6, label %then6, label %else6
+
+then6:
+  br label %join6
+
+else6:
+  br label %join6
+
+join6:
+  %c7 = icmp sgt i32 %a, 7
+  br i1 %c7, label %then7, label %else7
+
+then7:
+  br label %join7
+
+else7:
+  br label %join7
+
+join7:
+  %c8 = icmp sgt i32 %a, 8
+  br i1 %c8, label %then8, label %else8
+
+then8:
+  br label %join8
+
+else8:
+  br label %join8
+
+join8:
+  %c9 = icmp sgt i32 %a, 9
+  br i1 %c9, label %then9, label %else9
+
+then9:
+  br label %join9
+
+else9:
+  br label %join9
+
+join9:
+  %c10 = icmp sgt i32 %a, 10
+  br i1 %c10, label %then10, label %else10
+
+then10:
+  br label %join10
+
+else10:
+  br label %join10
+
+join10:
+  %c11 = icmp sgt i32 %a, 11
+  br i1 %c11, label %then11, label %else11
+
+then11:
+  br label %join11
+
+else11:
+  br label %join11
+
+join11:
+  %c12 = icmp sgt i32 %a, 12
+  br i1 %c12, label %then12, label %else12
+
+then12:
+  br label %join12
+
+else12:
+  br label %join12
+
+join12:
+  %c13 = icmp sgt i32 %a, 13
+  br i1 %c13, label %then13, label %else13
+
+then13:
+  br label %join13
+
+else13:
+  br label %join13
+
+join13:
+  %c14 = icmp sgt i32 %a, 14
+  br i1 %c14, label %then14, label %else14
+
+then14:
+  br label %join14
+
+else14:
+  br label %join14
+
+join14:
+  %c15 = icmp sgt i32 %a, 15
+  br i1 %c15, label %then15, label %else15
+
+then15:
+  br label %join15
+
+else15:
+  br label %join15
+
+join15:
+  %c16 = icmp sgt i32 %a, 16
+  br i1 %c16, label %then16, label %else16
+
+then16:
+  br label %join16
+
+else16:
+  br label %join16
+
+join16:
+  %c17 = icmp sgt i32 %a, 17
+  br i1 %c17, label %then17, label %else17
+
+then17:
+  br label %join17
+
+else17:
+  br label %join17
+
+join17:
+  %c18 = icmp sgt i32 %a, 18
+  br i1 %c18, label %then18, label %else18
+
+then18:
+  br label %join18
+
+else18:
+  br label %join18
+
+join18:
+  %c19 = icmp sgt i32 %a, 19
+  br i1 %c19, label %then19, label %else19
+
+then19:
+  br label %join19
+
+else19:
+  br label %join19
+
+join19:
+  %c20 = icmp sgt i32 %a, 20
+  br i1 %c20, label %then20, label %else20
+
+then20:
+  br label %join20
+
+else20:
+  br label %join20
+
+join20:
+  %c21 = icmp sgt i32 %a, 21
+  br i1 %c21, label %then21, label %else21
+
+then21:
+  br label %join21
+
+else21:
+  br label %join21
+
+join21:
+  %c22 = icmp sgt i32 %a, 22
+  br i1 %c22, label %then22, label %else22
+
+then22:
+  br label %join22
+
+else22:
+  br label %join22
+
+join22:
+  %c23 = icmp sgt i32 %a, 23
+  br i1 %c23, label %then23, label %else23
+
+then23:
+  br label %join23
+
+else23:
+  br label %join23
+
+join23:
+  %c24 = icmp sgt i32 %a, 24
+  br i1 %c24, label %then24, label %else24
+
+then24:
+  br label %join24
+
+else24:
+  br label %join24
+
+join24:
+  ret i32 0
+}
@@ -0,0 +1,30 @@
+; Switch cases sharing a target, then a straight-line chain
+define i32 @dispatch(i32 %x) {
+entry:
+  switch i32 %x, label %a [
+    i32 0, label %a
+    i32 1, label %a
+    i32 2, label %b
+  ], !prof !0
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %r = phi i32 [ 1, %a ], [ 2, %b ]
+  br label %tail
+
+tail:
+  %s = add i32 %r, 1
+  br label %done
+
+done:
+  ret i32 %s
+}
+
+; The slots into %a (the default and cases 0 and 1) are taken 6 times in 8,
+; each with its own weight
+!0 = !{!"branch_weights", i32 1, i32 2, i32 3, i32 2}
@@ -0,0 +1,112 @@
+; Eight diamonds in a row: 256 paths, evaluated by the bit-parallel fan-out
+; in four batches of 64. The diamonds alternate direct, indirect and PHI-gated
+; tainted calls, so the fan-out differs between paths.
+declare i32 @getinput()
+declare void @s0(i32)
+declare void @s1(i32)
+declare void @s2(i32)
+declare void @s3(i32)
+define void @dia(i32 %a, i32 %k, i1 %c0, i1 %c1, i1 %c2, i1 %c3, i1 %c4, i1 %c5, i1 %c6, i1 %c7, void (i32)* %fp) {
+entry:
+  %g = call i32 @getinput()
+  br label %d0
+d0:
+  br i1 %c0, label %l0, label %r0
+l0:
+  %x0 = add i32 %k, %g
+  call void @s0(i32 %x0)
+  br label %m0
+r0:
+  call void @s1(i32 5)
+  br label %m0
+m0:
+  %p0 = phi i32 [ %x0, %l0 ], [ 0, %r0 ]
+  br label %d1
+d1:
+  br i1 %c1, label %l1, label %r1
+l1:
+  %x1 = add i32 %p0, 1
+  call void @s1(i32 %x1)
+  br label %m1
+r1:
+  call void %fp(i32 %p0)
+  br label %m1
+m1:
+  %p1 = phi i32 [ %x1, %l1 ], [ 0, %r1 ]
+  br label %d2
+d2:
+  br i1 %c2, label %l2, label %r2
+l2:
+  %x2 = add i32 %p1, 1
+  call void @s2(i32 %x2)
+  br label %m2
+r2:
+  call void @s3(i32 5)
+  br label %m2
+m2:
+  %p2 = phi i32 [ %x2, %l2 ], [ 0, %r2 ]
+  br label %d3
+d3:
+  br i1 %c3, label %l3, label %r3
+l3:
+  %x3 = add i32 %p2, %g
+  call void @s3(i32 %x3)
+  br label %m3
+r3:
+  call void %fp(i32 %p2)
+  br label %m3
+m3:
+  %p3 = phi i32 [ %x3, %l3 ], [ 0, %r3 ]
+  br label %d4
+d4:
+  br i1 %c4, label %l4, label %r4
+l4:
+  %x4 = add i32 %p3, 1
+  call void @s0(i32 %x4)
+  br label %m4
+r4:
+  call void @s1(i32 5)
+  br label %m4
+m4:
+  %p4 = phi i32 [ %x4, %l4 ], [ 0, %r4 ]
+  br label %d5
+d5:
+  br i1 %c5, label %l5, label %r5
+l5:
+  %x5 = add i32 %p4, 1
+  call void @s1(i32 %x5)
+  br label %m5
+r5:
+  call void %fp(i32 %p4)
+  br label %m5
+m5:
+  %p5 = phi i32 [ %x5, %l5 ], [ 0, %r5 ]
+  br label %d6
+d6:
+  br i1 %c6, label %l6, label %r6
+l6:
+  %x6 = add i32 %p5, %g
+  call void @s2(i32 %x6)
+  br label %m6
+r6:
+  call void @s3(i32 5)
+  br label %m6
+m6:
+  %p6 = phi i32 [ %x6, %l6 ], [ 0, %r6 ]
+  br label %d7
+d7:
+  br i1 %c7, label %l7, label %r7
+l7:
+  %x7 = add i32 %p6, 1
+  call void @s3(i32 %x7)
+  br label %m7
+r7:
+  call void %fp(i32 %p6)
+  br label %m7
+m7:
+  %p7 = phi i32 [ %x7, %l7 ], [ 0, %r7 ]
+  br label %d8
+d8:
+  call void @s3(i32 %p7)
+  ret void
+}
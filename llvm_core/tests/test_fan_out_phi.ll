@@ -0,0 +1,31 @@
+; The loop-carried PHI %t only becomes tainted on the back edge from %b, so
+; the call to @sink in the first iteration sees an untainted value. With one
+; iteration the path reaches @sink2 with a tainted %t and the indirect call
+; with the tainted argument %a (fan-out 2); without it only the indirect
+; call counts (fan-out 1).
+declare i32 @read_input()
+declare void @sink(i32)
+declare void @sink2(i32)
+
+define void @phi_gated(i32 %a, i32 %n) {
+entry:
+  %x = call i32 @read_input()
+  br label %h
+
+h:
+  %i = phi i32 [0, %entry], [%i1, %b]
+  %t = phi i32 [0, %entry], [%x, %b]
+  %c = icmp slt i32 %i, %n
+  br i1 %c, label %b, label %exit
+
+b:
+  call void @sink(i32 %t)
+  %i1 = add i32 %i, 1
+  br label %h
+
+exit:
+  call void @sink2(i32 %t)
+  %fp = inttoptr i32 %a to void (i32)*
+  call void %fp(i32 %a)
+  ret void
+}
@@ -0,0 +1,47 @@
+; A loop whose body branches, so that with two iterations the enumeration
+; backtracks across both iterations. The header PHI %t is tainted only after
+; an iteration through %l, which taints the latch PHI %u; the DFS over the
+; enumeration tree has to roll both back when it leaves %l for %r.
+;   @sink(%t): tainted in the second iteration after an %l iteration
+;   @sink2(%u): tainted in any iteration through %l
+;   @sink3(%t): tainted on exit after an %l iteration
+;   indirect call through %a: always
+declare i32 @read_input()
+declare void @sink(i32)
+declare void @sink2(i32)
+declare void @sink3(i32)
+
+define void @undo(i32 %a, i32 %n) {
+entry:
+  %x = call i32 @read_input()
+  br label %h
+
+h:
+  %i = phi i32 [0, %entry], [%i1, %latch]
+  %t = phi i32 [0, %entry], [%u, %latch]
+  %c = icmp slt i32 %i, %n
+  br i1 %c, label %body, label %exit
+
+body:
+  call void @sink(i32 %t)
+  %d = icmp sgt i32 %i, 3
+  br i1 %d, label %l, label %r
+
+l:
+  br label %latch
+
+r:
+  br label %latch
+
+latch:
+  %u = phi i32 [%x, %l], [0, %r]
+  call void @sink2(i32 %u)
+  %i1 = add i32 %i, 1
+  br label %h
+
+exit:
+  call void @sink3(i32 %t)
+  %fp = inttoptr i32 %a to void (i32)*
+  call void %fp(i32 %a)
+  ret void
+}
@@ -0,0 +1,340 @@
+; Lock nesting for the lock depth states of
+; path-based-critical-section-traversal:
+;  - @balanced: every path unlocks what it locked
+;  - @unbalanced: one path returns with the lock held
+;  - @deep: 70 nested locks, deeper than the tracked depth, all released
+;  - @deepunbalanced: the same, with one path that keeps a lock
+declare void @mutex_lock()
+declare void @mutex_unlock()
+
+define void @balanced(i1 %c) {
+entry:
+  call void @mutex_lock()
+  br i1 %c, label %inner, label %done
+
+inner:
+  call void @mutex_lock()
+  call void @mutex_unlock()
+  br label %done
+
+done:
+  call void @mutex_unlock()
+  ret void
+}
+
+define void @unbalanced(i1 %c) {
+entry:
+  call void @mutex_lock()
+  br i1 %c, label %release, label %leak
+
+release:
+  call void @mutex_unlock()
+  ret void
+
+leak:
+  ret void
+}
+
+define void @deep() {
+entry:
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  br label %release
+
+release:
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  ret void
+}
+
+define void @deepunbalanced(i1 %c) {
+entry:
+  call void @mutex_lock()
+  br i1 %c, label %nest, label %leak
+
+nest:
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  call void @mutex_lock()
+  br label %release
+
+release:
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  call void @mutex_unlock()
+  ret void
+
+leak:
+  ret void
+}
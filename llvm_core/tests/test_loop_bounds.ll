@@ -0,0 +1,34 @@
+; Loops on which the loop bound of PathCounter and PathAlgebra (per entry of
+; a loop) differs from the one of PathEnumerator (per path):
+;  - @nested: an inner loop entered on every iteration of an outer one
+;  - @irreducible: a cycle entered at either of two blocks
+define void @nested(i1 %c, i1 %d) {
+entry:
+  br label %outer
+
+outer:
+  br label %inner
+
+inner:
+  br i1 %d, label %inner, label %latch
+
+latch:
+  br i1 %c, label %outer, label %exit
+
+exit:
+  ret void
+}
+
+define void @irreducible(i1 %c, i1 %d, i1 %e) {
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+  br i1 %d, label %right, label %exit
+
+right:
+  br i1 %e, label %left, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,118 @@
+; 11 diamonds in a row: 2^11 = 2048 paths, above the default path limit.
+define i32 @many_paths(i32 %a) {
+entry:
+  br label %join0
+
+join0:
+  %c1 = icmp sgt i32 %a, 1
+  br i1 %c1, label %then1, label %else1
+
+then1:
+  br label %join1
+
+else1:
+  br label %join1
+
+join1:
+  %c2 = icmp sgt i32 %a, 2
+  br i1 %c2, label %then2, label %else2
+
+then2:
+  br label %join2
+
+else2:
+  br label %join2
+
+join2:
+  %c3 = icmp sgt i32 %a, 3
+  br i1 %c3, label %then3, label %else3
+
+then3:
+  br label %join3
+
+else3:
+  br label %join3
+
+join3:
+  %c4 = icmp sgt i32 %a, 4
+  br i1 %c4, label %then4, label %else4
+
+then4:
+  br label %join4
+
+else4:
+  br label %join4
+
+join4:
+  %c5 = icmp sgt i32 %a, 5
+  br i1 %c5, label %then5, label %else5
+
+then5:
+  br label %join5
+
+else5:
+  br label %join5
+
+join5:
+  %c6 = icmp sgt i32 %a, 6
+  br i1 %c6, label %then6, label %else6
+
+then6:
+  br label %join6
+
+else6:
+  br label %join6
+
+join6:
+  %c7 = icmp sgt i32 %a, 7
+  br i1 %c7, label %then7, label %else7
+
+then7:
+  br label %join7
+
+else7:
+  br label %join7
+
+join7:
+  %c8 = icmp sgt i32 %a, 8
+  br i1 %c8, label %then8, label %else8
+
+then8:
+  br label %join8
+
+else8:
+  br label %join8
+
+join8:
+  %c9 = icmp sgt i32 %a, 9
+  br i1 %c9, label %then9, label %else9
+
+then9:
+  br label %join9
+
+else9:
+  br label %join9
+
+join9:
+  %c10 = icmp sgt i32 %a, 10
+  br i1 %c10, label %then10, label %else10
+
+then10:
+  br label %join10
+
+else10:
+  br label %join10
+
+join10:
+  %c11 = icmp sgt i32 %a, 11
+  br i1 %c11, label %then11, label %else11
+
+then11:
+  br label %join11
+
+else11:
+  br label %join11
+
+join11:
+  ret i32 0
+}
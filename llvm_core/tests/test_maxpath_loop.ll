@@ -0,0 +1,18 @@
+; A counted loop that loads, increments and stores back to %p. The store
+; and the next iteration's load form a loop-carried memory recurrence.
+define void @counted(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %v = load i32, i32* %p
+  %inc = add i32 %v, 1
+  store i32 %inc, i32* %p
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,87 @@
+; Functions whose memory dependences differ between the max-path tiers.
+declare void @sink(i32)
+declare void @abort() noreturn
+declare i32 @f(i32)
+declare i32 @g(i32, i32, i32, i32)
+declare void @h()
+
+@gp = global i32 0
+@gq = global i32 0
+
+; The store and the call are on exclusive paths: only the full scan chains
+; them, between the two loads of %p.
+define i32 @sw(i32 %a, i32* %p) {
+entry:
+  %v = load i32, i32* %p
+  switch i32 %a, label %d [ i32 0, label %c0
+                            i32 1, label %c0
+                            i32 2, label %c0
+                            i32 3, label %c1 ]
+c0:
+  store i32 1, i32* %p
+  br label %r
+c1:
+  call void @sink(i32 %a)
+  br label %r
+d:
+  call void @abort()
+  unreachable
+r:
+  %w = load i32, i32* %p
+  %s = add i32 %v, %w
+  ret i32 %s
+}
+
+; A store and a dependent load on a straight-line path
+define void @chain(i32 %a, i32* %p) {
+entry:
+  br label %b1
+b1:
+  store i32 %a, i32* %p
+  br label %b2
+b2:
+  %l = load i32, i32* %p
+  %c = icmp eq i32 %l, 0
+  br i1 %c, label %b3, label %b4
+b3:
+  br label %b5
+b4:
+  br label %b5
+b5:
+  br label %b6
+b6:
+  ret void
+}
+
+; A recurrence through four independent calls: inside the loop the full scan
+; chains every pair of calls, where the next-memory chain of auto only links
+; neighbours
+
+define i32 @recurrence(i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i5, %loop ]
+  %i1 = call i32 @f(i32 %i)
+  %i2 = call i32 @f(i32 %i)
+  %i3 = call i32 @f(i32 %i)
+  %i4 = call i32 @f(i32 %i)
+  %i5 = call i32 @g(i32 %i1, i32 %i2, i32 %i3, i32 %i4)
+  %cmp = icmp slt i32 %i5, %n
+  br i1 %cmp, label %loop, label %exit
+exit:
+  ret i32 %i5
+}
+
+; The store to @gq is the nearest definition the call depends on, but the
+; store to @gp does not conflict with it: the call depends on both stores
+define void @farther(i32 %a) {
+entry:
+  %c1 = add i32 %a, 1
+  %c2 = add i32 %c1, 2
+  %c = add i32 %c2, 3
+  store i32 %c, i32* @gp
+  store i32 2, i32* @gq
+  call void @h()
+  ret void
+}
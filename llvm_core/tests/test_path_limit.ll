@@ -0,0 +1,35 @@
+; Three diamonds in a row: exactly 8 paths from entry to exit.
+define i32 @diamonds(i32 %a, i32 %b, i32 %c) {
+entry:
+  %c1 = icmp sgt i32 %a, 0
+  br i1 %c1, label %then1, label %else1
+
+then1:
+  br label %join1
+
+else1:
+  br label %join1
+
+join1:
+  %c2 = icmp sgt i32 %b, 0
+  br i1 %c2, label %then2, label %else2
+
+then2:
+  br label %join2
+
+else2:
+  br label %join2
+
+join2:
+  %c3 = icmp sgt i32 %c, 0
+  br i1 %c3, label %then3, label %else3
+
+then3:
+  br label %join3
+
+else3:
+  br label %join3
+
+join3:
+  ret i32 0
+}
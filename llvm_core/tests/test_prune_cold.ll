@@ -0,0 +1,77 @@
+; Cold and noreturn code for prune-cold:
+;  - @checked: noreturn assertion failures, a cold call behind a !prof
+;    branch, and a loop whose rare exit leads to an assertion failure
+;  - @spin: a loop whose only exit is noreturn, beside a normal return
+;  - @spinonly: every exit is noreturn, so pruning would remove the entry
+declare void @abort() noreturn
+declare void @__assert_fail(i8*, i8*, i32, i8*) noreturn
+declare void @log_error() cold
+declare void @work()
+
+define i32 @checked(i32 %x, i32 %n) {
+entry:
+  %c0 = icmp sgt i32 %x, 0
+  br i1 %c0, label %ok0, label %fail0
+fail0:
+  call void @__assert_fail(i8* null, i8* null, i32 1, i8* null)
+  unreachable
+ok0:
+  %c1 = icmp slt i32 %x, 100
+  br i1 %c1, label %ok1, label %err, !prof !0
+err:
+  call void @log_error()
+  br label %ok1
+ok1:
+  br label %loop
+loop:
+  %i = phi i32 [0, %ok1], [%i1, %body]
+  %cl = icmp slt i32 %i, %n
+  br i1 %cl, label %body, label %done, !prof !1
+body:
+  call void @work()
+  %i1 = add i32 %i, 1
+  %c2 = icmp eq i32 %i, 7
+  br i1 %c2, label %rare, label %loop, !prof !2
+rare:
+  br label %fail1
+fail1:
+  call void @__assert_fail(i8* null, i8* null, i32 2, i8* null)
+  unreachable
+done:
+  %c3 = icmp eq i32 %x, 5
+  br i1 %c3, label %a, label %b
+a:
+  br label %ret
+b:
+  br label %ret
+ret:
+  ret i32 0
+}
+
+define void @spin(i1 %c, i1 %d) {
+entry:
+  br i1 %c, label %loop, label %ret
+loop:
+  br i1 %d, label %loop, label %fail
+fail:
+  call void @abort()
+  unreachable
+ret:
+  ret void
+}
+
+define void @spinonly(i1 %d, i1 %e) {
+entry:
+  br label %loop
+loop:
+  br i1 %d, label %body, label %fail
+body:
+  br i1 %e, label %loop, label %fail
+fail:
+  call void @abort()
+  unreachable
+}
+
+!0 = !{!"branch_weights", i32 2000, i32 1}
+!1 = !{!"branch_weights", i32 10000, i32 1}
+!2 = !{!"branch_weights", i32 1, i32 1}
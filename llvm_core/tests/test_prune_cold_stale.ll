@@ -0,0 +1,16 @@
+; A cold call that instcombine deletes, since @log_error has no side effects.
+; The CFG is unchanged, but %err is no longer cold once the call is gone.
+declare void @log_error() cold readnone nounwind willreturn
+
+define i32 @dead_cold(i32 %x) {
+entry:
+  %c = icmp sgt i32 %x, 0
+  br i1 %c, label %ok, label %err
+err:
+  call void @log_error()
+  br label %ret
+ok:
+  br label %ret
+ret:
+  ret i32 0
+}